@@ -52,6 +52,12 @@ namespace PhysicsEngine
 		CreateShape(PxConvexMeshGeometry(CookMesh(mesh_desc)), density);
 	}
 
+	// Constructor
+	ConvexMesh::ConvexMesh(PxConvexMesh* convex_mesh, const PxTransform& pose, PxReal density) : DynamicActor(pose)
+	{
+		CreateShape(PxConvexMeshGeometry(convex_mesh), density);
+	}
+
 	// Mesh cooking (preparation)
 	PxConvexMesh* ConvexMesh::CookMesh(const PxConvexMeshDesc& mesh_desc)
 	{
@@ -123,7 +129,7 @@ namespace PhysicsEngine
 		if (actor0)
 			px_actor0 = (PxRigidActor*)actor0->Get();
 
-		joint = (PxJoint*)PxDistanceJointCreate(*GetPhysics(), px_actor0, localFrame0, (PxRigidActor*)actor1->Get(), localFrame1);
+		joint = (PxJoint*)PxDistanceJointCreate(*GetPhysics(), px_actor0, localFrame0, actor1 ? (PxRigidActor*)actor1->Get() : 0, localFrame1);
 		joint->setConstraintFlag(PxConstraintFlag::eVISUALIZATION, true);
 		((PxDistanceJoint*)joint)->setDistanceJointFlag(PxDistanceJointFlag::eSPRING_ENABLED, true);
 		Damping(1.0f);
@@ -157,7 +163,7 @@ namespace PhysicsEngine
 		if (actor0)
 			px_actor0 = (PxRigidActor*)actor0->Get();
 
-		joint = PxRevoluteJointCreate(*GetPhysics(), px_actor0, localFrame0, (PxRigidActor*)actor1->Get(), localFrame1);
+		joint = PxRevoluteJointCreate(*GetPhysics(), px_actor0, localFrame0, actor1 ? (PxRigidActor*)actor1->Get() : 0, localFrame1);
 		joint->setConstraintFlag(PxConstraintFlag::eVISUALIZATION, true);
 	}
 
@@ -194,26 +200,6 @@ namespace PhysicsEngine
 
 	//*****COMPUND ACTORS*****
 
-	// Pitch 
-	PitchLines::PitchLines(const PxTransform& pose, PxVec3 dimensions, PxReal density) : DynamicActor(pose)
-	{
-		for (int i = 0; i < pitchLineDimensions.size(); i++)
-		{
-			CreateShape(PxBoxGeometry(pitchLineDimensions[i]), density);
-			GetShape(i)->setLocalPose(pitchLineTransforms[i]);
-		}
-	}
-
-	// Post
-	Post::Post(const PxTransform& pose, PxVec3 dimensions, PxReal density) : DynamicActor(pose)
-	{
-		for (int i = 0; i < postDimensions.size(); i++)
-		{
-			CreateShape(PxBoxGeometry(postDimensions[i]), density);
-			GetShape(i)->setLocalPose(postTransforms[i]);
-		}
-	}
-
 	// Catapult
 	Kicker::Kicker(const PxTransform& pose, PxVec3 dimensions, PxReal density) : DynamicActor(pose)
 	{
@@ -316,52 +302,6 @@ namespace PhysicsEngine
 		GetShape(9)->setLocalPose(PxTransform(PxVec3(0.0f, 0.0f, dimensions.z * 2.0f)));
 	}
 
-	// Walll class
-	Wall::Wall(const PxTransform& pose, PxVec3 dimensions, PxReal density) : DynamicActor(pose)
-	{
-		CreateShape(PxBoxGeometry(PxVec3(dimensions.x / 2.5f, dimensions.y, dimensions.z)), density);
-		GetShape(0)->setLocalPose(PxTransform(PxVec3(-dimensions.x + (dimensions.x / 2.5f), 0.0f, 0.0f)));
-
-		CreateShape(PxBoxGeometry(PxVec3(dimensions.x / 2.5f, dimensions.y, dimensions.z)), density);
-		GetShape(1)->setLocalPose(PxTransform(PxVec3(dimensions.x - (dimensions.x / 2.5f), 0.0f, 0.0f)));
-
-		CreateShape(PxBoxGeometry(PxVec3(dimensions.x / 10.0f, dimensions.y * 1.25f, dimensions.z * 2.5f)), density);
-		GetShape(2)->setLocalPose(PxTransform(PxVec3(-dimensions.x, dimensions.y - (dimensions.y / 1.25f), 0.0f)));
-
-		CreateShape(PxBoxGeometry(PxVec3(dimensions.x / 10.0f, dimensions.y * 1.25f, dimensions.z * 2.5f)), density);
-		GetShape(3)->setLocalPose(PxTransform(PxVec3(dimensions.x, dimensions.y - (dimensions.y / 1.25f), 0.0f)));
-
-		for (int i = 0; i < 5; i++)
-		{
-			CreateShape(PxBoxGeometry(PxVec3(dimensions.x / 30.0f, dimensions.y / 5.0f, dimensions.z)), density);
-			GetShape(4 + i)->setLocalPose(PxTransform(PxVec3((dimensions.x / 30.0f + (dimensions.x / 5.0f)) + (i * (dimensions.x / 7.0f)), dimensions.y, 0.0f)));
-		}
-
-		for (int i = 0; i < 5; i++)
-		{
-			CreateShape(PxBoxGeometry(PxVec3(dimensions.x / 30.0f, dimensions.y / 5.0f, dimensions.z)), density);
-			GetShape(9 + i)->setLocalPose(PxTransform(PxVec3((-dimensions.x / 30.0f - (dimensions.x / 5.0f)) - (i * (dimensions.x / 7.0f)), dimensions.y, 0.0f)));
-		}
-
-		CreateShape(PxBoxGeometry(PxVec3(dimensions.x / 30.0f, dimensions.y, dimensions.z * 36.0f)), density);
-		GetShape(14)->setLocalPose(PxTransform(PxVec3(dimensions.x, 0.0f, dimensions.z * 36.0f)));
-
-		CreateShape(PxBoxGeometry(PxVec3(dimensions.x / 30.0f, dimensions.y, dimensions.z * 36.0f)), density);
-		GetShape(15)->setLocalPose(PxTransform(PxVec3(-dimensions.x, 0.0f, dimensions.z * 36.0f)));
-
-		for (int i = 0; i < 15; i++)
-		{
-			CreateShape(PxBoxGeometry(PxVec3(dimensions.x / 30.0f, dimensions.y / 5.0f, dimensions.z)), density);
-			GetShape(16 + i)->setLocalPose(PxTransform(PxVec3(-dimensions.x, dimensions.y, ((dimensions.z * 72.0f) - dimensions.z) - (i * (dimensions.z * 5.0f)))));
-		}
-
-		for (int i = 0; i < 15; i++)
-		{
-			CreateShape(PxBoxGeometry(PxVec3(dimensions.x / 30.0f, dimensions.y / 5.0f, dimensions.z)), density);
-			GetShape(31 + i)->setLocalPose(PxTransform(PxVec3(dimensions.x, dimensions.y, ((dimensions.z * 72.0f) - dimensions.z) - (i * (dimensions.z * 5.0f)))));
-		}
-	}
-
 	// Ramp
 	Ramp::Ramp(float height, float width, float length, PxTransform pose, PxReal density)
 	{
@@ -392,6 +332,9 @@ namespace PhysicsEngine
 			//springs[3] = new DistanceJoint(bottom, PxTransform(PxVec3(-dimensions.x, thickness, -dimensions.z)), top, PxTransform(PxVec3(-dimensions.x, -dimensions.y, -dimensions.z)));
 		}
 
+		// The base never moves
+		bottom->Bake();
+
 		// Set the springs
 		springs.resize(4);
 		springs[0] = new DistanceJoint(bottom, PxTransform(PxVec3(dimensions.x, thickness, dimensions.z)), ramp->mesh, PxTransform(PxVec3(dimensions.x * 2.0f, -dimensions.y, dimensions.z * 2.0f)));
@@ -405,8 +348,6 @@ namespace PhysicsEngine
 			springs[i]->Stiffness(stiffness);
 			springs[i]->Damping(damping);
 		}
-
-		bottom->SetKinematic(true);
 	}
 
 	// Add trampoline
@@ -417,6 +358,12 @@ namespace PhysicsEngine
 		scene->Add(ramp->mesh);
 	}
 
+	// Parts in the scene
+	vector<Actor*> Trampoline::Parts()
+	{
+		return { bottom, ramp->mesh };
+	}
+
 	// Destructor
 	Trampoline::~Trampoline()
 	{
@@ -518,6 +465,18 @@ namespace PhysicsEngine
 		mesh = new ConvexMesh(vector<PxVec3>(begin(vertices), end(vertices)), pose, density);
 	}
 
+	// Rugby ball sharing a cooked hull
+	Ball::Ball(PxConvexMesh* hull, PxTransform pose, PxReal density)
+	{
+		mesh = new ConvexMesh(hull, pose, density);
+	}
+
+	// The cooked hull
+	PxConvexMesh* Ball::Hull()
+	{
+		return mesh->GetShape()->getGeometry().convexMesh().convexMesh;
+	}
+
 	// Wheel class
 	Wheel::Wheel(PxTransform pose, PxReal density)
 	{
@@ -60,6 +60,9 @@ namespace PhysicsEngine
 		// - denisty: 1kg/m^3
 		ConvexMesh(const std::vector<PxVec3>& verts, const PxTransform& pose = PxTransform(PxIdentity), PxReal density = 1.0f);
 
+		// Convex mesh sharing an already cooked hull
+		ConvexMesh(PxConvexMesh* convex_mesh, const PxTransform& pose = PxTransform(PxIdentity), PxReal density = 1.0f);
+
 		// Mesh cooking (preparation)
 		PxConvexMesh* CookMesh(const PxConvexMeshDesc& mesh_desc);
 	};
@@ -122,74 +125,16 @@ namespace PhysicsEngine
 		};
 
 		// Mesh
-		ConvexMesh* mesh = new ConvexMesh(vector<PxVec3>(begin(vertices), end(vertices)));
+		ConvexMesh* mesh;
 
 		// Constructor
 		Ball(PxTransform pose = PxTransform(PxIdentity), PxReal density = 1.0f);
-	};
-
-	// Pitch class
-	class PitchLines : public DynamicActor
-	{
-	public:
-
-		// Pitch line dimensions
-		vector<PxVec3> pitchLineDimensions =
-		{
-			PxVec3(0.25f, 1.0f,  100.0f),
-			PxVec3(0.25f, 1.0f,  100.0f),
-			PxVec3(70.0f, 1.0f,   0.25f),
-			PxVec3(70.0f, 1.0f,   0.25f),
-			PxVec3(70.0f, 1.0f,   0.25f),
-			PxVec3(70.0f, 1.0f,   0.25f),
-			PxVec3(70.0f, 1.0f,   0.25f)
-		};
-
-		// Pitch line transforms
-		vector<PxTransform> pitchLineTransforms =
-		{
-			PxTransform(PxVec3(70.0f,   0.0f,    0.0f)),
-			PxTransform(PxVec3(-70.0f,  0.0f,    0.0f)),
-			PxTransform(PxVec3(0.0f,    0.0f,  100.0f)),
-			PxTransform(PxVec3(0.0f,    0.0f, -100.0f)),
-			PxTransform(PxVec3(0.0f,    0.0f,   80.0f)),
-			PxTransform(PxVec3(0.0f,    0.0f,  -80.0f)),
-			PxTransform(PxVec3(0.0f,    0.0f,    0.0f))
-		};
-
-		// Pitch line
-		PitchLines(const PxTransform& pose = PxTransform(PxIdentity), PxVec3 dimensions = PxVec3(1.0f, 1.0f, 1.0f), PxReal density = 1.0f);
-	};
 
-	// Pitch class
-	class Post : public DynamicActor
-	{
-	public:
-
-		// Post dimensions
-		vector<PxVec3> postDimensions =
-		{
-			PxVec3(5.5f,  0.25f, 0.25f),
-			PxVec3(0.25f, 12.5f, 0.25f),
-			PxVec3(0.25f, 12.5f, 0.25f),
-			PxVec3(5.5f,  0.25f, 0.25f),
-			PxVec3(0.25f, 12.5f, 0.25f),
-			PxVec3(0.25f, 12.5f, 0.25f)
-		};
-
-		// Post transforms
-		vector<PxTransform> postTransforms =
-		{
-			PxTransform(PxVec3( 0.0f, 10.0f, -85.0f)),
-			PxTransform(PxVec3( 5.5f, 12.5f, -85.0f)),
-			PxTransform(PxVec3(-5.5f, 12.5f, -85.0f)),
-			PxTransform(PxVec3( 0.0f, 10.0f,  85.0f)),
-			PxTransform(PxVec3( 5.5f, 12.5f,  85.0f)),
-			PxTransform(PxVec3(-5.5f, 12.5f,  85.0f))
-		};
+		// Constructor - shares the hull of another ball
+		Ball(PxConvexMesh* hull, PxTransform pose = PxTransform(PxIdentity), PxReal density = 1.0f);
 
-		// Posts
-		Post(const PxTransform& pose = PxTransform(PxIdentity), PxVec3 dimensions = PxVec3(1.0f, 1.0f, 1.0f), PxReal density = 1.0f);
+		// The cooked hull
+		PxConvexMesh* Hull();
 	};
 
 	// Drawbridge class
@@ -226,14 +171,6 @@ namespace PhysicsEngine
 		Player(bool upJavalin, const PxTransform& pose = PxTransform(PxIdentity), PxVec3 dimensions = PxVec3(1.0f, 1.0f, 1.0f), PxReal density = 1.0f);
 	};
 
-	// Wall class
-	class Wall : public DynamicActor
-	{
-	public:
-		// Constructor
-		Wall(const PxTransform& pose = PxTransform(PxIdentity), PxVec3 dimensions = PxVec3(1.0f, 1.0f, 1.0f), PxReal density = 1.0f);
-	};
-
 	// Distance joint with the springs switched on
 	class DistanceJoint : public Joint
 	{
@@ -313,6 +250,9 @@ namespace PhysicsEngine
 		// Add
 		void AddToScene(Scene* scene);
 
+		// The parts added to the scene (base and bed)
+		vector<Actor*> Parts();
+
 		// Destructor
 		~Trampoline();
 	};
@@ -0,0 +1,140 @@
+#include "ClothLOD.h"
+
+// Physics engine namespace
+namespace PhysicsEngine
+{
+	// Fraction a threshold has to be passed by before the level changes back (stops flicker at the boundary)
+	static const PxReal hysteresis = 1.2f;
+
+	// Constructor
+	ClothLOD::ClothLOD(PxReal _full_pixels, PxReal _frozen_pixels, PxReal _reduced_frequency) :
+		eye(PxZero), dir(0.0f, 0.0f, -1.0f), fov(60.0f), width(1.0f), height(1.0f), has_view(false), full_pixels(_full_pixels), frozen_pixels(_frozen_pixels), reduced_frequency(_reduced_frequency)
+	{
+	}
+
+	// Set the camera
+	void ClothLOD::View(const PxVec3& _eye, const PxVec3& _dir, PxReal _fov, PxReal _width, PxReal _height)
+	{
+		eye = _eye;
+		dir = _dir.getNormalized();
+		fov = _fov;
+		width = PxMax(_width, 1.0f);
+		height = PxMax(_height, 1.0f);
+		has_view = true;
+	}
+
+	// Set the thresholds
+	void ClothLOD::Thresholds(PxReal _full_pixels, PxReal _frozen_pixels)
+	{
+		full_pixels = _full_pixels;
+		frozen_pixels = _frozen_pixels;
+	}
+
+	// Track a cloth
+	void ClothLOD::Track(Cloth* cloth)
+	{
+		PxCloth* px_cloth = (PxCloth*)cloth->Get();
+		Entry entry = { px_cloth, CLOTH_FULL, px_cloth->getSolverFrequency(), px_cloth->getSelfCollisionDistance(), px_cloth->getClothFlags().isSet(PxClothFlag::eSWEPT_CONTACT) };
+		entries.push_back(entry);
+	}
+
+	// Stop tracking everything
+	void ClothLOD::Clear()
+	{
+		entries.clear();
+	}
+
+	// Update the levels
+	void ClothLOD::Update()
+	{
+		// Pixels per world unit at unit distance, and the half angle of the cone around the view frustum
+		PxReal half_fov = PxTan(fov * PxPi / 360.0f);
+		PxReal pixels = (height * 0.5f) / half_fov;
+		PxReal aspect = width / height;
+		PxReal half_view = PxAtan(half_fov * PxSqrt(1.0f + aspect * aspect));
+
+		for (PxU32 i = 0; i < entries.size(); i++)
+		{
+			Entry& entry = entries[i];
+
+			// No camera (a scene nobody draws) - nothing to see
+			if (!has_view)
+			{
+				Apply(entry, CLOTH_FROZEN);
+				continue;
+			}
+
+			// Bounding sphere of the cloth
+			PxBounds3 bounds = entry.cloth->getWorldBounds();
+			PxVec3 to_cloth = bounds.getCenter() - eye;
+			PxReal radius = bounds.getExtents().magnitude();
+			PxReal distance = to_cloth.magnitude();
+
+			// Camera inside the cloth bounds - keep it full
+			if (distance <= radius)
+			{
+				Apply(entry, CLOTH_FULL);
+				continue;
+			}
+
+			// Behind the camera or outside the view cone
+			PxReal angle = PxAcos(PxClamp(to_cloth.dot(dir) / distance, -1.0f, 1.0f)) - PxAsin(radius / distance);
+			if (angle > half_view)
+			{
+				Apply(entry, CLOTH_FROZEN);
+				continue;
+			}
+
+			// Projected height on screen, with hysteresis around the current level
+			PxReal coverage = (2.0f * radius / distance) * pixels;
+			PxReal to_full = entry.level == CLOTH_FULL ? full_pixels / hysteresis : full_pixels;
+			PxReal to_reduced = entry.level == CLOTH_FROZEN ? frozen_pixels * hysteresis : frozen_pixels;
+
+			if (coverage >= to_full)
+				Apply(entry, CLOTH_FULL);
+			else if (coverage >= to_reduced)
+				Apply(entry, CLOTH_REDUCED);
+			else
+				Apply(entry, CLOTH_FROZEN);
+		}
+	}
+
+	// Change a cloth's level
+	void ClothLOD::Apply(Entry& entry, ClothLevel level)
+	{
+		if (entry.level == level)
+			return;
+
+		PxCloth* cloth = entry.cloth;
+		switch (level)
+		{
+		case CLOTH_FULL:
+			cloth->setSolverFrequency(entry.solver_frequency);
+			cloth->setSelfCollisionDistance(entry.self_collision_distance);
+			cloth->setClothFlag(PxClothFlag::eSWEPT_CONTACT, entry.swept_contact);
+			cloth->wakeUp();
+			break;
+		case CLOTH_REDUCED:
+			cloth->setSolverFrequency(PxMin(reduced_frequency, entry.solver_frequency));
+			cloth->setSelfCollisionDistance(0.0f);
+			cloth->setClothFlag(PxClothFlag::eSWEPT_CONTACT, false);
+			cloth->wakeUp();
+			break;
+		case CLOTH_FROZEN:
+			cloth->putToSleep();
+			break;
+		}
+
+		entry.level = level;
+	}
+
+	// Number of cloths at a level
+	PxU32 ClothLOD::Count(ClothLevel level)
+	{
+		PxU32 count = 0;
+		for (PxU32 i = 0; i < entries.size(); i++)
+			if (entries[i].level == level)
+				count++;
+		return count;
+	}
+}
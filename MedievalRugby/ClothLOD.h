@@ -0,0 +1,74 @@
+#pragma once
+#include "Actors.h"
+
+// Physics engine namespace
+namespace PhysicsEngine
+{
+	// Using the physx and std namespaces
+	using namespace physx;
+	using namespace std;
+
+	// How much work a cloth gets
+	enum ClothLevel
+	{
+		CLOTH_FULL,			// Authored solver frequency, self-collision and swept contact
+		CLOTH_REDUCED,		// Lower solver frequency, no self-collision or swept contact
+		CLOTH_FROZEN		// Asleep - not simulated at all
+	};
+
+	// Picks a level of detail for each tracked cloth from the camera distance and screen coverage
+	class ClothLOD
+	{
+	public:
+		// Constructor
+		ClothLOD(PxReal _full_pixels = 150.0f, PxReal _frozen_pixels = 25.0f, PxReal _reduced_frequency = 5.0f);
+
+		// Set the camera (vertical field of view in degrees, viewport size in pixels)
+		void View(const PxVec3& _eye, const PxVec3& _dir, PxReal _fov, PxReal _width, PxReal _height);
+
+		// Set the screen heights (pixels) below which a cloth is reduced or frozen
+		void Thresholds(PxReal _full_pixels, PxReal _frozen_pixels);
+
+		// Track a cloth, remembering its current settings as the full level
+		void Track(Cloth* cloth);
+
+		// Stop tracking everything
+		void Clear();
+
+		// Move every cloth to the level its screen coverage asks for
+		void Update();
+
+		// Number of tracked cloths at a level
+		PxU32 Count(ClothLevel level);
+
+	private:
+		// A tracked cloth
+		struct Entry
+		{
+			PxCloth* cloth;
+			ClothLevel level;
+			PxReal solver_frequency;
+			PxReal self_collision_distance;
+			bool swept_contact;
+		};
+
+		// Change a cloth's level
+		void Apply(Entry& entry, ClothLevel level);
+
+		// Tracked cloths
+		vector<Entry> entries;
+
+		// Camera
+		PxVec3 eye;
+		PxVec3 dir;
+		PxReal fov;
+		PxReal width;
+		PxReal height;
+		bool has_view;
+
+		// Thresholds
+		PxReal full_pixels;
+		PxReal frozen_pixels;
+		PxReal reduced_frequency;
+	};
+}
@@ -0,0 +1,89 @@
+#include "EntityTable.h"
+
+// Physics engine namespace
+namespace PhysicsEngine
+{
+	// Add an entity
+	PxU32 EntityTable::Add(Actor* _actor, EntityKind _kind, EntityTeam _team, PxU16 _group)
+	{
+		PxRigidDynamic* _body = _actor->Get()->isRigidDynamic();
+		if (!_body) throw new Exception("EntityTable::Add, Entities must be dynamic actors.");
+
+		actor.push_back(_actor);
+		body.push_back(_body);
+		kind.push_back((PxU8)_kind);
+		team.push_back((PxU8)_team);
+		group.push_back(_group);
+		state.push_back(0);
+		flags.push_back(0);
+		timer.push_back(0.0f);
+		home.push_back(_body->getGlobalPose());
+		return (PxU32)actor.size() - 1;
+	}
+
+	// Drop every entity
+	void EntityTable::Clear()
+	{
+		actor.clear();
+		body.clear();
+		kind.clear();
+		team.clear();
+		group.clear();
+		state.clear();
+		flags.clear();
+		timer.clear();
+		home.clear();
+		pos_x.clear();
+		pos_y.clear();
+		pos_z.clear();
+	}
+
+	// Number of entities
+	PxU32 EntityTable::Size()
+	{
+		return (PxU32)body.size();
+	}
+
+	// Number of entities of a kind
+	PxU32 EntityTable::Count(EntityKind _kind)
+	{
+		PxU32 count = 0;
+		for (PxU32 i = 0; i < kind.size(); i++)
+			count += kind[i] == _kind;
+		return count;
+	}
+
+	// Refresh flags and positions
+	void EntityTable::Gather()
+	{
+		PxU32 count = Size();
+		PxU32 padded = (count + 3) & ~3;
+		pos_x.resize(padded);
+		pos_y.resize(padded);
+		pos_z.resize(padded);
+
+		for (PxU32 i = 0; i < count; i++)
+		{
+			PxRigidDynamic* dynamic = body[i];
+			if (!dynamic->getScene())
+			{
+				flags[i] = 0;
+				continue;
+			}
+
+			PxU8 f = ENTITY_IN_SCENE;
+			if (dynamic->getRigidDynamicFlags() & PxRigidDynamicFlag::eKINEMATIC) f |= ENTITY_KINEMATIC;
+			else if (dynamic->isSleeping()) f |= ENTITY_SLEEPING;
+			flags[i] = f;
+
+			PxVec3 p = dynamic->getGlobalPose().p;
+			pos_x[i] = p.x;
+			pos_y[i] = p.y;
+			pos_z[i] = p.z;
+		}
+
+		// Padding is never in the scene
+		for (PxU32 i = count; i < padded; i++)
+			pos_x[i] = pos_y[i] = pos_z[i] = 0.0f;
+	}
+}
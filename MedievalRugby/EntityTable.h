@@ -0,0 +1,79 @@
+#pragma once
+#include "PhysicsEngine.h"
+
+// Physics engine namespace
+namespace PhysicsEngine
+{
+	// Using the physx and std namespaces
+	using namespace physx;
+	using namespace std;
+
+	// What an entity is
+	enum EntityKind
+	{
+		ENTITY_BALL,
+		ENTITY_BRICK,
+		ENTITY_FIREWORK,
+		ENTITY_BULLET
+	};
+
+	// Which side an entity belongs to
+	enum EntityTeam
+	{
+		TEAM_NONE,
+		TEAM_RED,
+		TEAM_BLUE
+	};
+
+	// Body state cached by Gather
+	enum EntityFlag
+	{
+		ENTITY_IN_SCENE		= (1 << 0),
+		ENTITY_SLEEPING		= (1 << 1),
+		ENTITY_KINEMATIC	= (1 << 2)
+	};
+
+	// Moving game props as a structure of arrays - per frame logic loops over the columns instead of chasing wrappers
+	class EntityTable
+	{
+	public:
+		// Add an entity (group is the castle, stack or pool slot it belongs to), returns its index
+		PxU32 Add(Actor* actor, EntityKind kind, EntityTeam team = TEAM_NONE, PxU16 group = 0);
+
+		// Drop every entity
+		void Clear();
+
+		// Number of entities
+		PxU32 Size();
+
+		// Number of entities of a kind
+		PxU32 Count(EntityKind kind);
+
+		// Refresh the flags and positions of every entity in one pass
+		void Gather();
+
+		// Wrapper and body handle
+		vector<Actor*> actor;
+		vector<PxRigidDynamic*> body;
+
+		// Kind, team and group
+		vector<PxU8> kind;
+		vector<PxU8> team;
+		vector<PxU16> group;
+
+		// Game state (owner defined, e.g. the ball pool state) and cached body flags
+		vector<PxU8> state;
+		vector<PxU8> flags;
+
+		// Owner defined timer (seconds)
+		vector<PxReal> timer;
+
+		// Pose the entity was spawned at (used to reset it)
+		vector<PxTransform> home;
+
+		// Positions from the last gather (padded to a multiple of 4)
+		vector<float> pos_x;
+		vector<float> pos_y;
+		vector<float> pos_z;
+	};
+}
@@ -0,0 +1,194 @@
+#include "Culling.h"
+#include <algorithm>
+
+// The visual debbuger namespace
+namespace VisualDebugger
+{
+	// Renderer namespace
+	namespace Renderer
+	{
+		// Items per leaf
+		static const PxU32 leaf_size = 4;
+
+		// Constructor
+		Frustum::Frustum() : valid(false)
+		{
+		}
+
+		// Set from the camera
+		void Frustum::Set(const PxVec3& eye, const PxVec3& dir, PxReal fov_y, PxReal aspect, PxReal near_distance, PxReal far_distance)
+		{
+			// Camera basis
+			PxVec3 forward = dir.getNormalized();
+			PxVec3 right = forward.cross(PxVec3(0.0f, 1.0f, 0.0f));
+			valid = right.magnitudeSquared() > 1e-6f;
+			if (!valid)
+				return;
+
+			right.normalize();
+			PxVec3 up = right.cross(forward);
+
+			PxReal tan_v = PxTan(fov_y * 0.5f * PxPi / 180.0f);
+			PxReal tan_h = tan_v * aspect;
+
+			planes[0] = PxPlane(eye + forward * near_distance, forward);
+			planes[1] = PxPlane(eye + forward * far_distance, -forward);
+			planes[2] = PxPlane(eye, (right + forward * tan_h).getNormalized());
+			planes[3] = PxPlane(eye, (-right + forward * tan_h).getNormalized());
+			planes[4] = PxPlane(eye, (-up + forward * tan_v).getNormalized());
+			planes[5] = PxPlane(eye, (up + forward * tan_v).getNormalized());
+		}
+
+		// Classify bounds
+		CullResult Frustum::Classify(const PxBounds3& bounds) const
+		{
+			if (!valid)
+				return CULL_INSIDE;
+
+			PxVec3 center = bounds.getCenter();
+			PxVec3 extents = bounds.getExtents();
+
+			CullResult result = CULL_INSIDE;
+			for (PxU32 i = 0; i < 6; i++)
+			{
+				// Distance of the centre and the reach of the box along the normal
+				PxReal distance = planes[i].distance(center);
+				PxReal reach = extents.dot(planes[i].n.abs());
+
+				if (distance < -reach)
+					return CULL_OUTSIDE;
+				if (distance < reach)
+					result = CULL_INTERSECTS;
+			}
+			return result;
+		}
+
+		// Visible
+		bool Frustum::Visible(const PxBounds3& bounds) const
+		{
+			return Classify(bounds) != CULL_OUTSIDE;
+		}
+
+		// Build
+		void BoundsTree::Build(const std::vector<PxBounds3>& bounds)
+		{
+			nodes.clear();
+			item_bounds.clear();
+			items.resize(bounds.size());
+			for (PxU32 i = 0; i < items.size(); i++)
+				items[i] = i;
+
+			if (items.empty())
+				return;
+
+			nodes.reserve(items.size() * 2);
+			nodes.push_back(Node());
+			Split(0, 0, (PxU32)items.size(), bounds);
+
+			// Leaf order, so a leaf tests its items without going back to the source
+			item_bounds.resize(items.size());
+			for (PxU32 i = 0; i < items.size(); i++)
+				item_bounds[i] = bounds[items[i]];
+		}
+
+		// Split
+		void BoundsTree::Split(PxU32 node, PxU32 begin, PxU32 end, const std::vector<PxBounds3>& bounds)
+		{
+			PxBounds3 node_bounds = PxBounds3::empty();
+			PxBounds3 centers = PxBounds3::empty();
+			for (PxU32 i = begin; i < end; i++)
+			{
+				node_bounds.include(bounds[items[i]]);
+				centers.include(bounds[items[i]].getCenter());
+			}
+			nodes[node].bounds = node_bounds;
+
+			if (end - begin <= leaf_size)
+			{
+				nodes[node].first = begin;
+				nodes[node].count = end - begin;
+				return;
+			}
+
+			// Median of the centres along the longest axis
+			PxVec3 spread = centers.getDimensions();
+			PxU32 axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+			PxU32 middle = (begin + end) / 2;
+			std::nth_element(items.begin() + begin, items.begin() + middle, items.begin() + end,
+				[&bounds, axis](PxU32 a, PxU32 b) { return bounds[a].getCenter()[axis] < bounds[b].getCenter()[axis]; });
+
+			// Children are pushed together so the second is always first + 1
+			PxU32 children = (PxU32)nodes.size();
+			nodes[node].first = children;
+			nodes[node].count = 0;
+			nodes.push_back(Node());
+			nodes.push_back(Node());
+
+			Split(children, begin, middle, bounds);
+			Split(children + 1, middle, end, bounds);
+		}
+
+		// Query
+		void BoundsTree::Query(const Frustum& frustum, std::vector<PxU32>& visible) const
+		{
+			if (nodes.empty())
+				return;
+
+			// Depth first without recursion (the tree is balanced, so 64 levels is plenty)
+			PxU32 stack[64];
+			PxU32 top = 0;
+			stack[top++] = 0;
+
+			while (top)
+			{
+				const PxU32 index = stack[--top];
+				const Node& node = nodes[index];
+
+				CullResult result = frustum.Classify(node.bounds);
+				if (result == CULL_OUTSIDE)
+					continue;
+
+				// Wholly inside - no need to test anything below
+				if (result == CULL_INSIDE)
+				{
+					AddAll(index, visible);
+					continue;
+				}
+
+				if (node.count)
+				{
+					for (PxU32 i = node.first; i < node.first + node.count; i++)
+					{
+						if (frustum.Visible(item_bounds[i]))
+							visible.push_back(items[i]);
+					}
+				}
+				else
+				{
+					stack[top++] = node.first;
+					stack[top++] = node.first + 1;
+				}
+			}
+		}
+
+		// Append every item under a node
+		void BoundsTree::AddAll(PxU32 node, std::vector<PxU32>& visible) const
+		{
+			if (nodes[node].count)
+			{
+				for (PxU32 i = nodes[node].first; i < nodes[node].first + nodes[node].count; i++)
+					visible.push_back(items[i]);
+				return;
+			}
+
+			AddAll(nodes[node].first, visible);
+			AddAll(nodes[node].first + 1, visible);
+		}
+
+		// Size
+		PxU32 BoundsTree::Size() const
+		{
+			return (PxU32)items.size();
+		}
+	}
+}
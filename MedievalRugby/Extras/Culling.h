@@ -0,0 +1,80 @@
+#pragma once
+#include "PxPhysicsAPI.h"
+#include <vector>
+
+// Visual debugger namespace
+namespace VisualDebugger
+{
+	// Renderer namespace
+	namespace Renderer
+	{
+		// PhysX namespace
+		using namespace physx;
+
+		// Where bounds lie against the frustum
+		enum CullResult
+		{
+			CULL_OUTSIDE,
+			CULL_INTERSECTS,
+			CULL_INSIDE
+		};
+
+		// The camera view volume as six inward facing planes
+		class Frustum
+		{
+		public:
+			// Constructor (everything visible until set)
+			Frustum();
+
+			// Set from the camera - vertical field of view in degrees, y up like gluLookAt
+			void Set(const PxVec3& eye, const PxVec3& dir, PxReal fov_y, PxReal aspect, PxReal near_distance, PxReal far_distance);
+
+			// Classify bounds against the planes
+			CullResult Classify(const PxBounds3& bounds) const;
+
+			// Are the bounds at least partly inside?
+			bool Visible(const PxBounds3& bounds) const;
+
+		private:
+			// Near, far, left, right, top, bottom
+			PxPlane planes[6];
+
+			// False when the camera looks straight up or down (nothing is culled)
+			bool valid;
+		};
+
+		// A bounding volume hierarchy over items that don't move (static props), built top down by median split
+		class BoundsTree
+		{
+		public:
+			// Build over the bounds of the items (item i has bounds[i])
+			void Build(const std::vector<PxBounds3>& bounds);
+
+			// Append the items whose bounds are at least partly inside the frustum, skipping whole subtrees outside it
+			void Query(const Frustum& frustum, std::vector<PxU32>& visible) const;
+
+			// Number of items
+			PxU32 Size() const;
+
+		private:
+			// A node - leaves hold count items from first, inner nodes (count 0) have their children at first and first + 1
+			struct Node
+			{
+				PxBounds3 bounds;
+				PxU32 first;
+				PxU32 count;
+			};
+
+			// Split the items [begin, end) under a node
+			void Split(PxU32 node, PxU32 begin, PxU32 end, const std::vector<PxBounds3>& bounds);
+
+			// Append every item under a node
+			void AddAll(PxU32 node, std::vector<PxU32>& visible) const;
+
+			// Nodes (root first), the items in leaf order and their bounds
+			std::vector<Node> nodes;
+			std::vector<PxU32> items;
+			std::vector<PxBounds3> item_bounds;
+		};
+	}
+}
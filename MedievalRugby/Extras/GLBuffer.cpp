@@ -0,0 +1,134 @@
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include "GLBuffer.h"
+
+#ifdef _WIN32
+#define GetGLProcAddress(name) wglGetProcAddress(name)
+#else
+#include <GL/glx.h>
+#define GetGLProcAddress(name) glXGetProcAddressARB((const GLubyte*)name)
+#endif
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+// Visual debugger namespace
+namespace VisualDebugger
+{
+	// Renderer namespace
+	namespace Renderer
+	{
+		// Buffer object entry points (OpenGL 1.5 / ARB_vertex_buffer_object)
+		typedef void (APIENTRY *GenBuffersProc)(GLsizei n, GLuint* buffers);
+		typedef void (APIENTRY *DeleteBuffersProc)(GLsizei n, const GLuint* buffers);
+		typedef void (APIENTRY *BindBufferProc)(GLenum target, GLuint buffer);
+		typedef void (APIENTRY *BufferDataProc)(GLenum target, ptrdiff_t size, const GLvoid* data, GLenum usage);
+		typedef void (APIENTRY *BufferSubDataProc)(GLenum target, ptrdiff_t offset, ptrdiff_t size, const GLvoid* data);
+
+		static GenBuffersProc gl_gen_buffers = 0;
+		static DeleteBuffersProc gl_delete_buffers = 0;
+		static BindBufferProc gl_bind_buffer = 0;
+		static BufferDataProc gl_buffer_data = 0;
+		static BufferSubDataProc gl_buffer_sub_data = 0;
+
+		// Look up a core entry point, then the ARB one
+		void* LoadProc(const char* core, const char* arb)
+		{
+			void* proc = (void*)GetGLProcAddress(core);
+			if (!proc) proc = (void*)GetGLProcAddress(arb);
+			return proc;
+		}
+
+		// Load the entry points
+		bool LoadBufferFunctions()
+		{
+			gl_gen_buffers		= (GenBuffersProc)LoadProc("glGenBuffers", "glGenBuffersARB");
+			gl_delete_buffers	= (DeleteBuffersProc)LoadProc("glDeleteBuffers", "glDeleteBuffersARB");
+			gl_bind_buffer		= (BindBufferProc)LoadProc("glBindBuffer", "glBindBufferARB");
+			gl_buffer_data		= (BufferDataProc)LoadProc("glBufferData", "glBufferDataARB");
+			gl_buffer_sub_data	= (BufferSubDataProc)LoadProc("glBufferSubData", "glBufferSubDataARB");
+
+			return BuffersSupported();
+		}
+
+		// Buffer objects available?
+		bool BuffersSupported()
+		{
+			return gl_gen_buffers && gl_delete_buffers && gl_bind_buffer && gl_buffer_data && gl_buffer_sub_data;
+		}
+
+		// Constructor
+		GLBuffer::GLBuffer(GLenum _target, GLenum _usage) : id(0), target(_target), usage(_usage), capacity(0), size(0), client(0)
+		{
+		}
+
+		// Destructor
+		GLBuffer::~GLBuffer()
+		{
+			Release();
+		}
+
+		// Upload
+		void GLBuffer::Upload(const void* data, size_t bytes)
+		{
+			client = data;
+			size = bytes;
+
+			if (!BuffersSupported())
+				return;
+
+			if (!id)
+				gl_gen_buffers(1, &id);
+
+			gl_bind_buffer(target, id);
+
+			// Grow (and orphan) only when needed, otherwise overwrite in place
+			if (bytes > capacity)
+			{
+				gl_buffer_data(target, (ptrdiff_t)bytes, data, usage);
+				capacity = bytes;
+			}
+			else
+				gl_buffer_sub_data(target, 0, (ptrdiff_t)bytes, data);
+
+			gl_bind_buffer(target, 0);
+		}
+
+		// Bind
+		const GLvoid* GLBuffer::Bind() const
+		{
+			if (!id)
+				return client;
+
+			gl_bind_buffer(target, id);
+			return 0;
+		}
+
+		// Unbind
+		void GLBuffer::Unbind() const
+		{
+			if (id)
+				gl_bind_buffer(target, 0);
+		}
+
+		// Size
+		size_t GLBuffer::Size() const
+		{
+			return size;
+		}
+
+		// Release
+		void GLBuffer::Release()
+		{
+			if (id && BuffersSupported())
+				gl_delete_buffers(1, &id);
+
+			id = 0;
+			capacity = 0;
+			size = 0;
+			client = 0;
+		}
+	}
+}
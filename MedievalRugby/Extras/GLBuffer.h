@@ -0,0 +1,74 @@
+#pragma once
+#include <GL/glut.h>
+#include <cstddef>
+
+// Buffer object enums missing from OpenGL 1.1 headers
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER			0x8892
+#define GL_ELEMENT_ARRAY_BUFFER	0x8893
+#define GL_STREAM_DRAW			0x88E0
+#define GL_STATIC_DRAW			0x88E4
+#define GL_DYNAMIC_DRAW			0x88E8
+#endif
+
+// Visual debugger namespace
+namespace VisualDebugger
+{
+	// Renderer namespace
+	namespace Renderer
+	{
+		// Look up a GL entry point by its core name, then its ARB name (null if the driver has neither)
+		void* LoadProc(const char* core, const char* arb);
+
+		// Load the buffer object entry points (needs a current GL context)
+		bool LoadBufferFunctions();
+
+		// Buffer objects available? (false = client side arrays)
+		bool BuffersSupported();
+
+		// A persistent GL buffer object, falling back to the client copy on drivers without buffer objects
+		class GLBuffer
+		{
+		public:
+			// Constructor
+			GLBuffer(GLenum _target = GL_ARRAY_BUFFER, GLenum _usage = GL_STREAM_DRAW);
+
+			// Destructor
+			~GLBuffer();
+
+			// Copy data into the buffer, growing it only when it is too small
+			void Upload(const void* data, size_t bytes);
+
+			// Bind the buffer and return the base pointer for gl*Pointer / glDrawElements
+			const GLvoid* Bind() const;
+
+			// Unbind the buffer target
+			void Unbind() const;
+
+			// Bytes uploaded last
+			size_t Size() const;
+
+			// Free the GL buffer
+			void Release();
+
+		private:
+			// No copies - the GL name is owned
+			GLBuffer(const GLBuffer&);
+			GLBuffer& operator=(const GLBuffer&);
+
+			// GL buffer name (0 when buffer objects are not supported)
+			GLuint id;
+
+			// Buffer target and usage
+			GLenum target;
+			GLenum usage;
+
+			// Allocated and used bytes
+			size_t capacity;
+			size_t size;
+
+			// Client data when buffer objects are not supported
+			const void* client;
+		};
+	}
+}
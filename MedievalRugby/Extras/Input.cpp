@@ -0,0 +1,171 @@
+#include "Input.h"
+#include <chrono>
+#include <ctype.h>
+#include <string.h>
+
+// The visual debbuger namespace
+namespace VisualDebugger
+{
+	// Constructor
+	Input::Input() : active(0), touched(0), last_poll(Now()), latency_count(0), latency_average(0.0f)
+	{
+		memset(map, none, sizeof(map));
+		memset(keys, 0, sizeof(keys));
+		for (PxU32 i = 0; i < ACTION_COUNT; i++)
+		{
+			since[i] = 0.0;
+			held[i] = 0.0f;
+		}
+	}
+
+	// Map a key to an action
+	void Input::Map(unsigned char key, InputAction action)
+	{
+		map[toupper(key)] = (PxU8)action;
+		map[tolower(key)] = (PxU8)action;
+	}
+
+	// Queue a key event
+	void Input::Push(unsigned char key, bool down)
+	{
+		key = (unsigned char)toupper(key);
+
+		// Auto repeat and stray releases change nothing
+		PxU32 bit = 1u << (key & 31);
+		if (((keys[key >> 5] & bit) != 0) == down)
+			return;
+
+		if (down) keys[key >> 5] |= bit;
+		else keys[key >> 5] &= ~bit;
+
+		InputEvent event = { key, down, Now() };
+		queue.push_back(event);
+	}
+
+	// Drain the queue
+	void Input::Poll(void (*handler)(const InputEvent& event))
+	{
+		double now = Now();
+
+		// Nothing held and nothing happened - the common case
+		if (!active && queue.empty())
+		{
+			if (touched)
+			{
+				for (PxU32 i = 0; i < ACTION_COUNT; i++)
+					held[i] = 0.0f;
+				touched = 0;
+			}
+			last_poll = now;
+			return;
+		}
+
+		for (PxU32 i = 0; i < ACTION_COUNT; i++)
+			held[i] = 0.0f;
+		touched = active;
+
+		// Events in the order they happened
+		for (PxU32 i = 0; i < queue.size(); i++)
+		{
+			const InputEvent& event = queue[i];
+			if (handler) handler(event);
+			undelivered.push_back(event.time);
+
+			PxU8 action = map[event.key];
+			if (action == none)
+				continue;
+
+			PxU32 bit = 1u << action;
+			if (event.down && !(active & bit))
+			{
+				active |= bit;
+				touched |= bit;
+				since[action] = event.time;
+			}
+			else if (!event.down && (active & bit))
+			{
+				active &= ~bit;
+				held[action] += (PxReal)(event.time - (since[action] > last_poll ? since[action] : last_poll));
+			}
+		}
+		queue.clear();
+
+		// Still held - held until now
+		for (PxU32 i = 0; i < ACTION_COUNT; i++)
+		{
+			if (active & (1u << i))
+				held[i] += (PxReal)(now - (since[i] > last_poll ? since[i] : last_poll));
+		}
+		last_poll = now;
+	}
+
+	// Actions held now
+	PxU32 Input::Active()
+	{
+		return active;
+	}
+
+	// Actions held since the previous poll
+	PxU32 Input::Touched()
+	{
+		return touched;
+	}
+
+	// Held time in the last window
+	PxReal Input::Held(InputAction action)
+	{
+		return held[action];
+	}
+
+	// Is a key down
+	bool Input::Down(unsigned char key)
+	{
+		key = (unsigned char)toupper(key);
+		return (keys[key >> 5] & (1u << (key & 31))) != 0;
+	}
+
+	// Record the latency of the delivered events
+	void Input::Stepped()
+	{
+		if (undelivered.empty())
+			return;
+
+		double now = Now();
+		for (PxU32 i = 0; i < undelivered.size(); i++)
+		{
+			PxReal latency = (PxReal)((now - undelivered[i]) * 1000.0);
+			latencies[latency_count++ % latency_window] = latency;
+			latency_average = latency_count == 1 ? latency : latency_average + (latency - latency_average) * 0.2f;
+		}
+		undelivered.clear();
+	}
+
+	// Drop the undelivered events
+	void Input::Discard()
+	{
+		undelivered.clear();
+	}
+
+	// Averaged latency
+	PxReal Input::Latency()
+	{
+		return latency_average;
+	}
+
+	// Worst recent latency
+	PxReal Input::LatencyMax()
+	{
+		PxReal worst = 0.0f;
+		PxU32 count = latency_count < latency_window ? latency_count : latency_window;
+		for (PxU32 i = 0; i < count; i++)
+			if (latencies[i] > worst) worst = latencies[i];
+		return worst;
+	}
+
+	// Seconds since start up
+	double Input::Now()
+	{
+		static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "foundation/PxSimpleTypes.h"
+#include <vector>
+
+// The visual debbuger namespace
+namespace VisualDebugger
+{
+	// Using physx namespace
+	using namespace physx;
+
+	// Held actions the keys map to
+	enum InputAction
+	{
+		ACTION_CAMERA_FORWARD,
+		ACTION_CAMERA_BACKWARD,
+		ACTION_CAMERA_LEFT,
+		ACTION_CAMERA_RIGHT,
+		ACTION_CAMERA_UP,
+		ACTION_CAMERA_DOWN,
+		ACTION_COUNT
+	};
+
+	// A key going down or up, stamped with the time it happened
+	struct InputEvent
+	{
+		unsigned char key;
+		bool down;
+		double time;
+	};
+
+	// Key events queued as they arrive, drained once per frame - held actions are a bitset with their held time measured from the event stamps
+	class Input
+	{
+	public:
+		// Constructor
+		Input();
+
+		// Map a key (either case) to a held action
+		void Map(unsigned char key, InputAction action);
+
+		// Queue a key press or release (auto repeat is dropped)
+		void Push(unsigned char key, bool down);
+
+		// Pass the queued events to the handler in order and work out how long every action was held since the last poll
+		void Poll(void (*handler)(const InputEvent& event));
+
+		// Actions held now
+		PxU32 Active();
+
+		// Actions held at any time since the previous poll (the ones that need dispatching)
+		PxU32 Touched();
+
+		// Seconds an action was held between the last two polls
+		PxReal Held(InputAction action);
+
+		// Is a key down
+		bool Down(unsigned char key);
+
+		// The events polled so far have reached a simulation step - record how long each one waited
+		void Stepped();
+
+		// The events polled so far will never reach a step (the scene is paused) - drop them without recording a latency
+		void Discard();
+
+		// Input to physics latency, averaged over recent events (ms)
+		PxReal Latency();
+
+		// Worst input to physics latency of the last latency_window events (ms)
+		PxReal LatencyMax();
+
+		// Seconds since start up
+		static double Now();
+
+	private:
+		// Action per key (none = unmapped)
+		static const PxU8 none = 0xff;
+		PxU8 map[256];
+
+		// Keys down (bitset)
+		PxU32 keys[256 / 32];
+
+		// Queued events
+		std::vector<InputEvent> queue;
+
+		// Held actions and the ones seen since the last poll
+		PxU32 active;
+		PxU32 touched;
+
+		// When each held action went down, and its held time in the last window
+		double since[ACTION_COUNT];
+		PxReal held[ACTION_COUNT];
+
+		// Time of the last poll
+		double last_poll;
+
+		// Stamps of the polled events that have not reached a step yet
+		std::vector<double> undelivered;
+
+		// Recent latencies (ms, ring buffer) and their running average
+		static const PxU32 latency_window = 32;
+		PxReal latencies[latency_window];
+		PxU32 latency_count;
+		PxReal latency_average;
+	};
+}
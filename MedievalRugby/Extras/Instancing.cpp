@@ -0,0 +1,409 @@
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include "Instancing.h"
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+// Shader enums missing from OpenGL 1.1 headers
+#ifndef GL_VERTEX_SHADER
+#define GL_FRAGMENT_SHADER		0x8B30
+#define GL_VERTEX_SHADER		0x8B31
+#define GL_COMPILE_STATUS		0x8B81
+#define GL_LINK_STATUS			0x8B82
+#endif
+
+// The visual debbuger namespace
+namespace VisualDebugger
+{
+	// Renderer namespace
+	namespace Renderer
+	{
+		// Shader entry points (OpenGL 2.0)
+		typedef GLuint (APIENTRY *CreateShaderProc)(GLenum type);
+		typedef void (APIENTRY *ShaderSourceProc)(GLuint shader, GLsizei count, const char* const* source, const GLint* length);
+		typedef void (APIENTRY *CompileShaderProc)(GLuint shader);
+		typedef void (APIENTRY *GetShaderivProc)(GLuint shader, GLenum name, GLint* value);
+		typedef GLuint (APIENTRY *CreateProgramProc)();
+		typedef void (APIENTRY *AttachShaderProc)(GLuint program, GLuint shader);
+		typedef void (APIENTRY *BindAttribLocationProc)(GLuint program, GLuint index, const char* name);
+		typedef void (APIENTRY *LinkProgramProc)(GLuint program);
+		typedef void (APIENTRY *GetProgramivProc)(GLuint program, GLenum name, GLint* value);
+		typedef void (APIENTRY *UseProgramProc)(GLuint program);
+		typedef GLint (APIENTRY *GetUniformLocationProc)(GLuint program, const char* name);
+		typedef void (APIENTRY *Uniform1iProc)(GLint location, GLint value);
+		typedef void (APIENTRY *Uniform4fProc)(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+		typedef void (APIENTRY *EnableVertexAttribArrayProc)(GLuint index);
+		typedef void (APIENTRY *DisableVertexAttribArrayProc)(GLuint index);
+		typedef void (APIENTRY *VertexAttribPointerProc)(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid* pointer);
+
+		// Instancing entry points (OpenGL 3.3 / ARB_draw_instanced and ARB_instanced_arrays)
+		typedef void (APIENTRY *VertexAttribDivisorProc)(GLuint index, GLuint divisor);
+		typedef void (APIENTRY *DrawElementsInstancedProc)(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices, GLsizei instances);
+
+		static CreateShaderProc gl_create_shader = 0;
+		static ShaderSourceProc gl_shader_source = 0;
+		static CompileShaderProc gl_compile_shader = 0;
+		static GetShaderivProc gl_get_shader_iv = 0;
+		static CreateProgramProc gl_create_program = 0;
+		static AttachShaderProc gl_attach_shader = 0;
+		static BindAttribLocationProc gl_bind_attrib_location = 0;
+		static LinkProgramProc gl_link_program = 0;
+		static GetProgramivProc gl_get_program_iv = 0;
+		static UseProgramProc gl_use_program = 0;
+		static GetUniformLocationProc gl_get_uniform_location = 0;
+		static Uniform1iProc gl_uniform_1i = 0;
+		static Uniform4fProc gl_uniform_4f = 0;
+		static EnableVertexAttribArrayProc gl_enable_vertex_attrib_array = 0;
+		static DisableVertexAttribArrayProc gl_disable_vertex_attrib_array = 0;
+		static VertexAttribPointerProc gl_vertex_attrib_pointer = 0;
+		static VertexAttribDivisorProc gl_vertex_attrib_divisor = 0;
+		static DrawElementsInstancedProc gl_draw_elements_instanced = 0;
+
+		// Instancing program and its uniforms
+		static GLuint program = 0;
+		static GLint lit_location = -1;
+		static GLint flat_color_location = -1;
+
+		// First of the five instance attributes (four transform columns, then the colour) - clear of the attributes the fixed function arrays alias
+		static const GLuint instance_attribute = 8;
+
+		// Transform the unit mesh by the instance, then light it like the fixed function light 0 (or leave it flat for shadows)
+		static const char* vertex_shader =
+			"#version 120\n"
+			"attribute vec4 instance_column0;\n"
+			"attribute vec4 instance_column1;\n"
+			"attribute vec4 instance_column2;\n"
+			"attribute vec4 instance_column3;\n"
+			"attribute vec4 instance_color;\n"
+			"uniform int lit;\n"
+			"uniform vec4 flat_color;\n"
+			"varying vec4 color;\n"
+			"void main()\n"
+			"{\n"
+			"	mat4 instance = mat4(instance_column0, instance_column1, instance_column2, instance_column3);\n"
+			"	gl_Position = gl_ModelViewProjectionMatrix * (instance * gl_Vertex);\n"
+			"	if (lit == 0)\n"
+			"	{\n"
+			"		color = flat_color;\n"
+			"		return;\n"
+			"	}\n"
+			"	vec3 n = normalize(gl_NormalMatrix * (mat3(instance) * gl_Normal));\n"
+			"	vec3 l = normalize(gl_LightSource[0].position.xyz);\n"
+			"	float diffuse = max(dot(n, l), 0.0);\n"
+			"	color = instance_color * (gl_LightModel.ambient + gl_LightSource[0].ambient + gl_LightSource[0].diffuse * diffuse);\n"
+			"	if (diffuse > 0.0)\n"
+			"		color.rgb += gl_FrontLightProduct[0].specular.rgb * pow(max(dot(n, normalize(l + vec3(0.0, 0.0, 1.0))), 0.0), gl_FrontMaterial.shininess);\n"
+			"	color.a = instance_color.a;\n"
+			"}\n";
+
+		static const char* fragment_shader =
+			"#version 120\n"
+			"varying vec4 color;\n"
+			"void main()\n"
+			"{\n"
+			"	gl_FragColor = color;\n"
+			"}\n";
+
+		// Compile a shader (0 on failure)
+		static GLuint CompileShader(GLenum type, const char* source)
+		{
+			GLuint shader = gl_create_shader(type);
+			gl_shader_source(shader, 1, &source, 0);
+			gl_compile_shader(shader);
+
+			GLint compiled = 0;
+			gl_get_shader_iv(shader, GL_COMPILE_STATUS, &compiled);
+			return compiled ? shader : 0;
+		}
+
+		// Build the instancing program (0 on failure)
+		static GLuint BuildProgram()
+		{
+			GLuint vertex = CompileShader(GL_VERTEX_SHADER, vertex_shader);
+			GLuint fragment = CompileShader(GL_FRAGMENT_SHADER, fragment_shader);
+			if (!vertex || !fragment)
+				return 0;
+
+			GLuint built = gl_create_program();
+			gl_attach_shader(built, vertex);
+			gl_attach_shader(built, fragment);
+			gl_bind_attrib_location(built, instance_attribute + 0, "instance_column0");
+			gl_bind_attrib_location(built, instance_attribute + 1, "instance_column1");
+			gl_bind_attrib_location(built, instance_attribute + 2, "instance_column2");
+			gl_bind_attrib_location(built, instance_attribute + 3, "instance_column3");
+			gl_bind_attrib_location(built, instance_attribute + 4, "instance_color");
+			gl_link_program(built);
+
+			GLint linked = 0;
+			gl_get_program_iv(built, GL_LINK_STATUS, &linked);
+			if (!linked)
+				return 0;
+
+			lit_location = gl_get_uniform_location(built, "lit");
+			flat_color_location = gl_get_uniform_location(built, "flat_color");
+			return built;
+		}
+
+		// Load the entry points
+		bool LoadInstancingFunctions()
+		{
+			gl_create_shader				= (CreateShaderProc)LoadProc("glCreateShader", "glCreateShaderObjectARB");
+			gl_shader_source				= (ShaderSourceProc)LoadProc("glShaderSource", "glShaderSourceARB");
+			gl_compile_shader				= (CompileShaderProc)LoadProc("glCompileShader", "glCompileShaderARB");
+			gl_get_shader_iv				= (GetShaderivProc)LoadProc("glGetShaderiv", "glGetObjectParameterivARB");
+			gl_create_program				= (CreateProgramProc)LoadProc("glCreateProgram", "glCreateProgramObjectARB");
+			gl_attach_shader				= (AttachShaderProc)LoadProc("glAttachShader", "glAttachObjectARB");
+			gl_bind_attrib_location			= (BindAttribLocationProc)LoadProc("glBindAttribLocation", "glBindAttribLocationARB");
+			gl_link_program					= (LinkProgramProc)LoadProc("glLinkProgram", "glLinkProgramARB");
+			gl_get_program_iv				= (GetProgramivProc)LoadProc("glGetProgramiv", "glGetObjectParameterivARB");
+			gl_use_program					= (UseProgramProc)LoadProc("glUseProgram", "glUseProgramObjectARB");
+			gl_get_uniform_location			= (GetUniformLocationProc)LoadProc("glGetUniformLocation", "glGetUniformLocationARB");
+			gl_uniform_1i					= (Uniform1iProc)LoadProc("glUniform1i", "glUniform1iARB");
+			gl_uniform_4f					= (Uniform4fProc)LoadProc("glUniform4f", "glUniform4fARB");
+			gl_enable_vertex_attrib_array	= (EnableVertexAttribArrayProc)LoadProc("glEnableVertexAttribArray", "glEnableVertexAttribArrayARB");
+			gl_disable_vertex_attrib_array	= (DisableVertexAttribArrayProc)LoadProc("glDisableVertexAttribArray", "glDisableVertexAttribArrayARB");
+			gl_vertex_attrib_pointer		= (VertexAttribPointerProc)LoadProc("glVertexAttribPointer", "glVertexAttribPointerARB");
+			gl_vertex_attrib_divisor		= (VertexAttribDivisorProc)LoadProc("glVertexAttribDivisor", "glVertexAttribDivisorARB");
+			gl_draw_elements_instanced		= (DrawElementsInstancedProc)LoadProc("glDrawElementsInstanced", "glDrawElementsInstancedARB");
+
+			program = 0;
+			if (BuffersSupported() && gl_create_shader && gl_shader_source && gl_compile_shader && gl_get_shader_iv && gl_create_program && gl_attach_shader &&
+				gl_bind_attrib_location && gl_link_program && gl_get_program_iv && gl_use_program && gl_get_uniform_location && gl_uniform_1i && gl_uniform_4f &&
+				gl_enable_vertex_attrib_array && gl_disable_vertex_attrib_array && gl_vertex_attrib_pointer && gl_vertex_attrib_divisor && gl_draw_elements_instanced)
+				program = BuildProgram();
+
+			return InstancingSupported();
+		}
+
+		// Instanced draws available?
+		bool InstancingSupported()
+		{
+			return program != 0;
+		}
+
+		// Add an interleaved vertex
+		static void AddVertex(UnitMesh& mesh, const PxVec3& p, const PxVec3& n)
+		{
+			float vertex[] = { p.x, p.y, p.z, n.x, n.y, n.z };
+			mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + 6);
+		}
+
+		// Index a grid of (rows + 1) x (columns + 1) vertices as triangles
+		static void AddGrid(UnitMesh& mesh, GLushort first, int rows, int columns)
+		{
+			for (int r = 0; r < rows; r++)
+			{
+				for (int c = 0; c < columns; c++)
+				{
+					GLushort a = (GLushort)(first + r * (columns + 1) + c);
+					GLushort b = (GLushort)(a + columns + 1);
+					GLushort quad[] = { a, b, (GLushort)(a + 1), (GLushort)(a + 1), b, (GLushort)(b + 1) };
+					mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+				}
+			}
+		}
+
+		// Build a unit shape
+		void BuildUnitMesh(UnitMesh& mesh, InstanceShape shape, int detail)
+		{
+			// Keep the sphere grid within 16 bit indices
+			detail = PxClamp(detail, 3, 128);
+
+			mesh.vertices.clear();
+			mesh.indices.clear();
+
+			switch (shape)
+			{
+			case INSTANCE_BOX:
+				{
+					// Four corners per face so every face keeps its own normal
+					for (PxU32 axis = 0; axis < 3; axis++)
+					{
+						for (int side = -1; side <= 1; side += 2)
+						{
+							PxVec3 n(0.0f), u(0.0f), v(0.0f);
+							n[axis] = (float)side;
+							u[(axis + 1) % 3] = 1.0f;
+							v[(axis + 2) % 3] = (float)side;
+
+							GLushort first = (GLushort)(mesh.vertices.size() / 6);
+							AddVertex(mesh, n - u - v, n);
+							AddVertex(mesh, n + u - v, n);
+							AddVertex(mesh, n + u + v, n);
+							AddVertex(mesh, n - u + v, n);
+
+							GLushort face[] = { first, (GLushort)(first + 1), (GLushort)(first + 2), first, (GLushort)(first + 2), (GLushort)(first + 3) };
+							mesh.indices.insert(mesh.indices.end(), face, face + 6);
+						}
+					}
+				}
+				break;
+
+			case INSTANCE_SPHERE:
+				{
+					// Stacks from pole to pole, slices around y
+					for (int stack = 0; stack <= detail; stack++)
+					{
+						float theta = PxPi * stack / detail;
+						for (int slice = 0; slice <= detail; slice++)
+						{
+							float phi = PxTwoPi * slice / detail;
+							PxVec3 p(PxSin(theta) * PxCos(phi), PxCos(theta), -PxSin(theta) * PxSin(phi));
+							AddVertex(mesh, p, p);
+						}
+					}
+					AddGrid(mesh, 0, detail, detail);
+				}
+				break;
+
+			case INSTANCE_HEMISPHERE:
+				{
+					// Rings from the pole at +x to the equator, matching the cylinder slices
+					int stacks = (detail + 1) / 2;
+					for (int stack = 0; stack <= stacks; stack++)
+					{
+						float theta = PxHalfPi * stack / stacks;
+						for (int slice = 0; slice <= detail; slice++)
+						{
+							float phi = PxTwoPi * slice / detail;
+							PxVec3 p(PxCos(theta), PxSin(theta) * PxCos(phi), PxSin(theta) * PxSin(phi));
+							AddVertex(mesh, p, p);
+						}
+					}
+					AddGrid(mesh, 0, stacks, detail);
+				}
+				break;
+
+			case INSTANCE_CYLINDER:
+				{
+					// Open tube along x (capsules close it with their spheres)
+					for (int end = 0; end <= 1; end++)
+					{
+						for (int slice = 0; slice <= detail; slice++)
+						{
+							float phi = PxTwoPi * slice / detail;
+							PxVec3 n(0.0f, PxCos(phi), PxSin(phi));
+							AddVertex(mesh, PxVec3(end ? 1.0f : -1.0f, n.y, n.z), n);
+						}
+					}
+					AddGrid(mesh, 0, 1, detail);
+				}
+				break;
+
+			default: break;
+			}
+
+			mesh.vertex_buffer.Upload(mesh.vertices.data(), mesh.vertices.size() * sizeof(float));
+			mesh.index_buffer.Upload(mesh.indices.data(), mesh.indices.size() * sizeof(GLushort));
+			mesh.detail = detail;
+		}
+
+		// Constructor
+		InstanceBatch::InstanceBatch() : instance_buffer(GL_ARRAY_BUFFER, GL_STREAM_DRAW), uploaded(false)
+		{
+		}
+
+		// Clear
+		void InstanceBatch::Clear()
+		{
+			instances.clear();
+			uploaded = false;
+		}
+
+		// Add an instance
+		void InstanceBatch::Add(const PxMat44& transform, const PxVec3& color)
+		{
+			const float* m = transform.front();
+			instances.insert(instances.end(), m, m + 16);
+
+			float rgba[] = { color.x, color.y, color.z, 1.0f };
+			instances.insert(instances.end(), rgba, rgba + 4);
+			uploaded = false;
+		}
+
+		// Size
+		PxU32 InstanceBatch::Size() const
+		{
+			return (PxU32)(instances.size() / stride);
+		}
+
+		// Draw
+		void InstanceBatch::Draw(const UnitMesh& mesh, const PxVec4* flat_color)
+		{
+			if (instances.empty())
+				return;
+
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glEnableClientState(GL_NORMAL_ARRAY);
+
+			const char* base = (const char*)mesh.vertex_buffer.Bind();
+			glVertexPointer(3, GL_FLOAT, 6 * sizeof(float), base);
+			glNormalPointer(GL_FLOAT, 6 * sizeof(float), base + 3 * sizeof(float));
+
+			const GLvoid* indices = mesh.index_buffer.Bind();
+			const GLsizei index_count = (GLsizei)mesh.indices.size();
+
+			if (InstancingSupported())
+			{
+				// Shadows draw the same instances again - upload them once per frame
+				if (!uploaded)
+				{
+					instance_buffer.Upload(instances.data(), instances.size() * sizeof(float));
+					uploaded = true;
+				}
+
+				gl_use_program(program);
+				gl_uniform_1i(lit_location, flat_color ? 0 : 1);
+				if (flat_color)
+					gl_uniform_4f(flat_color_location, flat_color->x, flat_color->y, flat_color->z, flat_color->w);
+
+				// One attribute step per instance
+				const char* instance_base = (const char*)instance_buffer.Bind();
+				for (GLuint i = 0; i < 5; i++)
+				{
+					gl_enable_vertex_attrib_array(instance_attribute + i);
+					gl_vertex_attrib_pointer(instance_attribute + i, 4, GL_FLOAT, GL_FALSE, stride * sizeof(float), instance_base + i * 4 * sizeof(float));
+					gl_vertex_attrib_divisor(instance_attribute + i, 1);
+				}
+				instance_buffer.Unbind();
+
+				gl_draw_elements_instanced(GL_TRIANGLES, index_count, GL_UNSIGNED_SHORT, indices, (GLsizei)Size());
+
+				for (GLuint i = 0; i < 5; i++)
+				{
+					gl_vertex_attrib_divisor(instance_attribute + i, 0);
+					gl_disable_vertex_attrib_array(instance_attribute + i);
+				}
+				gl_use_program(0);
+			}
+			else
+			{
+				// Same buffers, one draw per instance - the transforms carry the scale, so renormalise
+				glEnable(GL_NORMALIZE);
+				if (flat_color)
+					glColor4f(flat_color->x, flat_color->y, flat_color->z, flat_color->w);
+
+				for (PxU32 i = 0; i < instances.size(); i += stride)
+				{
+					if (!flat_color)
+						glColor4fv(&instances[i + 16]);
+
+					glPushMatrix();
+					glMultMatrixf(&instances[i]);
+					glDrawElements(GL_TRIANGLES, index_count, GL_UNSIGNED_SHORT, indices);
+					glPopMatrix();
+				}
+				glDisable(GL_NORMALIZE);
+			}
+
+			mesh.index_buffer.Unbind();
+			mesh.vertex_buffer.Unbind();
+
+			glDisableClientState(GL_NORMAL_ARRAY);
+			glDisableClientState(GL_VERTEX_ARRAY);
+		}
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "GLBuffer.h"
+#include "PxPhysicsAPI.h"
+#include <vector>
+
+// Visual debugger namespace
+namespace VisualDebugger
+{
+	// Renderer namespace
+	namespace Renderer
+	{
+		// PhysX namespace
+		using namespace physx;
+
+		// Unit shapes drawn instanced (capsules are two hemispheres and a cylinder)
+		enum InstanceShape
+		{
+			INSTANCE_BOX,
+			INSTANCE_SPHERE,
+			INSTANCE_HEMISPHERE,
+			INSTANCE_CYLINDER,
+			INSTANCE_SHAPE_COUNT
+		};
+
+		// Load the shader and instancing entry points and build the instancing program (needs a current GL context)
+		bool LoadInstancingFunctions();
+
+		// Instanced draws available? (false = one draw per instance from the same buffers)
+		bool InstancingSupported();
+
+		// A unit shape in vertex / index buffers - box and cylinder span -1..1, the spheres have radius 1 (the hemisphere bulges towards +x)
+		struct UnitMesh
+		{
+			// Interleaved position / normal vertices and triangle indices
+			std::vector<float> vertices;
+			std::vector<GLushort> indices;
+
+			// GL buffers
+			GLBuffer vertex_buffer;
+			GLBuffer index_buffer;
+
+			// Tessellation the mesh was built with (0 = not built)
+			int detail;
+
+			UnitMesh() : vertex_buffer(GL_ARRAY_BUFFER, GL_STATIC_DRAW), index_buffer(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW), detail(0) {}
+		};
+
+		// Build a unit shape (spheres, hemispheres and cylinders get detail slices, boxes ignore it)
+		void BuildUnitMesh(UnitMesh& mesh, InstanceShape shape, int detail);
+
+		// The instances of one unit shape gathered over a frame - a transform (scale folded in) and a colour each
+		class InstanceBatch
+		{
+		public:
+			// Constructor
+			InstanceBatch();
+
+			// Drop the instances (keeps the memory)
+			void Clear();
+
+			// Add an instance
+			void Add(const PxMat44& transform, const PxVec3& color);
+
+			// Number of instances
+			PxU32 Size() const;
+
+			// Draw every instance of the mesh in the current modelview - lit in its own colour, or unlit in the rgba flat_color when given (shadows)
+			void Draw(const UnitMesh& mesh, const PxVec4* flat_color = 0);
+
+		private:
+			// No copies - the GL buffer is owned
+			InstanceBatch(const InstanceBatch&);
+			InstanceBatch& operator=(const InstanceBatch&);
+
+			// Column major transform then rgba colour per instance
+			static const PxU32 stride = 20;
+			std::vector<float> instances;
+
+			// Instance data uploaded once per frame
+			GLBuffer instance_buffer;
+			bool uploaded;
+		};
+	}
+}
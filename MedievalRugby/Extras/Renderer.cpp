@@ -1,4 +1,11 @@
 #include "Renderer.h"
+#include <unordered_map>
+#include <xmmintrin.h>
+
+// Byte order of the PhysX debug colours, missing from OpenGL 1.1 headers
+#ifndef GL_BGRA
+#define GL_BGRA 0x80E1
+#endif
 
 // Using the std namespace
 using namespace std;
@@ -15,12 +22,77 @@ namespace VisualDebugger
 		// Background colour
 		PxVec3 background_color = PxVec3(0.0f, 0.0f, 0.0f);
 
-		// Render detail
+		// Render detail (quality bias for the sphere and capsule level of detail)
 		int render_detail = 10;
 
 		// Show shadows?
 		bool show_shadows = true;
 
+		// Only shapes this close to the camera cast shadows
+		PxReal shadow_distance = 150.0f;
+
+		// Frame counter (render data not drawn for a while is released)
+		static PxU32 frame = 0;
+
+		// Planar shadow projection along the light
+		static const PxVec3 shadow_dir(-0.7071067f, -0.7071067f, -0.7071067f);
+		static const PxReal shadow_matrix[] = { 1,0,0,0, -shadow_dir.x / shadow_dir.y, 0, -shadow_dir.z / shadow_dir.y, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+		// Shadows darken what they fall on by a tenth (blended once per pixel)
+		static const PxVec4 shadow_color(0.0f, 0.0f, 0.0f, 0.1f);
+
+		// A shape drawn one by one that casts a shadow this frame
+		struct ShadowCaster
+		{
+			PxMat44 pose;
+			PxGeometryHolder geometry;
+		};
+
+		// Slices of each level of detail (boxes only use the first)
+		static const PxU32 lod_count = 5;
+		static const int lod_detail[lod_count] = { 6, 10, 16, 24, 40 };
+
+		// Unit shapes per level of detail, their instances this frame and the instances near enough to cast shadows
+		static UnitMesh unit_meshes[INSTANCE_SHAPE_COUNT][lod_count];
+		static InstanceBatch instance_batches[INSTANCE_SHAPE_COUNT][lod_count];
+		static InstanceBatch shadow_batches[INSTANCE_SHAPE_COUNT][lod_count];
+
+		// Other shapes casting shadows this frame
+		static std::vector<ShadowCaster> shadow_casters;
+
+		// Camera position and screen pixels per unit of size at unit distance (for the level of detail)
+		static PxVec3 camera_eye(0.0f);
+		static PxReal pixels_per_unit = 1.0f;
+
+		// Camera view volume this frame
+		static Frustum frustum;
+
+		// Static shapes this frame, and the ones the tree was built from (planes are kept out of it)
+		static std::vector<const PxShape*> frame_static_shapes;
+		static std::vector<const PxShape*> static_shapes_all;
+		static std::vector<const PxShape*> static_planes;
+		static std::vector<const PxShape*> static_shapes;
+		static BoundsTree static_tree;
+		static bool static_tree_shadows = false;
+		static PxU32 static_tree_generation = 0;
+
+		// Static shapes the tree found in view, and the other actors this frame
+		static std::vector<PxU32> visible_statics;
+		static std::vector<PxActor*> frame_actors;
+
+		// Shapes of the actor being drawn (only grows)
+		static std::vector<PxShape*> shape_buffer;
+
+		// Shapes considered and culled this frame
+		static PxU32 shapes_total = 0;
+		static PxU32 shapes_culled = 0;
+
+		// Can colour arrays read BGRA bytes? (OpenGL 3.2 / ARB_vertex_array_bgra) - the debug colours are then used as they are
+		static bool bgra_colors = false;
+
+		// Debug vertices with red and blue swapped, for drivers that can't (only grows)
+		static std::vector<PxDebugPoint> debug_vertices;
+
 		// Plane data
 		static float gPlaneData[] =
 		{
@@ -42,50 +114,128 @@ namespace VisualDebugger
 			glDisableClientState(GL_NORMAL_ARRAY);
 		}
 
-		// Draw a sphere
-		void DrawSphere(const PxGeometryHolder& geometry)
+		// Per mesh render data - triangulated once, drawn with one call per instance
+		struct MeshBuffers
 		{
-			glutSolidSphere(geometry.sphere().radius, render_detail, render_detail);
+			// Interleaved position / normal vertices and triangle indices while building (no indices = drawn in vertex order)
+			std::vector<float> vertices;
+			std::vector<GLuint> indices;
+
+			// Indices narrowed to 16 bit when every vertex fits
+			std::vector<GLushort> short_indices;
+			GLenum index_type;
+
+			// Counts as uploaded (the CPU copies are freed once they are in buffer objects)
+			GLsizei vertex_count;
+			GLsizei index_count;
+
+			// GL buffers
+			GLBuffer vertex_buffer;
+			GLBuffer index_buffer;
+
+			// Source counts (a different mesh at a reused address is rebuilt)
+			PxU32 source_vertices;
+			PxU32 source_faces;
+
+			// Last frame the mesh was drawn
+			PxU32 last_frame;
+
+			MeshBuffers() : index_type(GL_UNSIGNED_SHORT), vertex_count(0), index_count(0), vertex_buffer(GL_ARRAY_BUFFER, GL_STATIC_DRAW), index_buffer(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW), source_vertices(0), source_faces(0), last_frame(0) {}
+		};
+
+		// Mesh render data by mesh
+		static std::unordered_map<const void*, MeshBuffers*> mesh_buffers;
+
+		// How many frames an undrawn mesh keeps its buffers
+		static const PxU32 mesh_buffer_lifetime = 300;
+
+		// Get the cached render data of a mesh (null if it has to be built)
+		static MeshBuffers* FindMeshBuffers(const void* mesh, PxU32 source_vertices, PxU32 source_faces, bool& build)
+		{
+			MeshBuffers*& buffers = mesh_buffers[mesh];
+			if (!buffers)
+				buffers = new MeshBuffers();
+
+			build = buffers->source_vertices != source_vertices || buffers->source_faces != source_faces;
+			if (build)
+			{
+				buffers->vertices.clear();
+				buffers->indices.clear();
+				buffers->short_indices.clear();
+				buffers->source_vertices = source_vertices;
+				buffers->source_faces = source_faces;
+			}
+
+			buffers->last_frame = frame;
+			return buffers;
 		}
 
-		// Draw a box
-		void DrawBox(const PxGeometryHolder& geometry)
+		// Upload the built vertices and indices, narrowing the indices to 16 bit when they fit
+		static void UploadMeshBuffers(MeshBuffers* buffers)
 		{
+			buffers->vertex_count = (GLsizei)(buffers->vertices.size() / 6);
+			buffers->index_count = (GLsizei)buffers->indices.size();
+			buffers->vertex_buffer.Upload(buffers->vertices.data(), buffers->vertices.size() * sizeof(float));
 
-			PxVec3 half_size = geometry.box().halfExtents;
-			glScalef(half_size.x, half_size.y, half_size.z);
-			glutSolidCube(2.0f);
+			if (buffers->index_count && buffers->vertex_count <= 0xffff)
+			{
+				buffers->short_indices.assign(buffers->indices.begin(), buffers->indices.end());
+				std::vector<GLuint>().swap(buffers->indices);
+				buffers->index_buffer.Upload(buffers->short_indices.data(), buffers->short_indices.size() * sizeof(GLushort));
+				buffers->index_type = GL_UNSIGNED_SHORT;
+			}
+			else if (buffers->index_count)
+			{
+				buffers->index_buffer.Upload(buffers->indices.data(), buffers->indices.size() * sizeof(GLuint));
+				buffers->index_type = GL_UNSIGNED_INT;
+			}
 
+			// The buffer objects hold the data now - only the client array fallback draws from these
+			if (BuffersSupported())
+			{
+				std::vector<float>().swap(buffers->vertices);
+				std::vector<GLuint>().swap(buffers->indices);
+				std::vector<GLushort>().swap(buffers->short_indices);
+			}
 		}
 
-		// Draw a capsule
-		void DrawCapsule(const PxGeometryHolder& geometry)
+		// Draw the cached triangles in the current transform
+		static void DrawMeshBuffers(const MeshBuffers* buffers)
 		{
-			const PxF32 radius = geometry.capsule().radius;
-			const PxF32 halfHeight = geometry.capsule().halfHeight;
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glEnableClientState(GL_NORMAL_ARRAY);
 
-			//Sphere
-			glPushMatrix();
-			glTranslatef(halfHeight, 0.0f, 0.0f);
-			glutSolidSphere(radius, render_detail, render_detail);		
-			glPopMatrix();
+			const char* base = (const char*)buffers->vertex_buffer.Bind();
+			glVertexPointer(3, GL_FLOAT, 6 * sizeof(float), base);
+			glNormalPointer(GL_FLOAT, 6 * sizeof(float), base + 3 * sizeof(float));
 
-			//Sphere
-			glPushMatrix();
-			glTranslatef(-halfHeight, 0.0f, 0.0f);
-			glutSolidSphere(radius, render_detail, render_detail);		
-			glPopMatrix();
+			if (buffers->index_count)
+			{
+				glDrawElements(GL_TRIANGLES, buffers->index_count, buffers->index_type, buffers->index_buffer.Bind());
+				buffers->index_buffer.Unbind();
+			}
+			else
+				glDrawArrays(GL_TRIANGLES, 0, buffers->vertex_count);
 
-			//Cylinder
-			glPushMatrix();
-			glTranslatef(-halfHeight, 0.0f,0.0f);
-			glRotatef(90.0f, 0.0f, 1.0f, 0.0f);
+			buffers->vertex_buffer.Unbind();
 
-			GLUquadric* qobj = gluNewQuadric();
-			gluQuadricNormals(qobj, GLU_SMOOTH);
-			gluCylinder(qobj, radius, radius, halfHeight * 2.0f, render_detail, render_detail);
-			gluDeleteQuadric(qobj);
-			glPopMatrix();
+			glDisableClientState(GL_NORMAL_ARRAY);
+			glDisableClientState(GL_VERTEX_ARRAY);
+		}
+
+		// Free the render data of meshes that have not been drawn for a while
+		static void ReleaseStaleMeshBuffers()
+		{
+			for (std::unordered_map<const void*, MeshBuffers*>::iterator it = mesh_buffers.begin(); it != mesh_buffers.end();)
+			{
+				if (frame - it->second->last_frame > mesh_buffer_lifetime)
+				{
+					delete it->second;
+					it = mesh_buffers.erase(it);
+				}
+				else
+					++it;
+			}
 		}
 
 		// Draw a convex mesh
@@ -93,49 +243,91 @@ namespace VisualDebugger
 		{
 			PxConvexMesh* mesh = geometry.convexMesh().convexMesh;
 			PxU32 num_polys = mesh->getNbPolygons();
-			const PxVec3* verts = mesh->getVertices();
-			const PxU8* indicies = mesh->getIndexBuffer();
 
-			for (PxU32 i = 0; i < num_polys; i++)
+			bool build;
+			MeshBuffers* buffers = FindMeshBuffers(mesh, mesh->getNbVertices(), num_polys, build);
+
+			// First use - fan every polygon into triangles with the polygon normal
+			if (build)
 			{
-				PxHullPolygon face;
-				if (mesh->getPolygonData(i,face))
+				const PxVec3* verts = mesh->getVertices();
+				const PxU8* indicies = mesh->getIndexBuffer();
+
+				for (PxU32 i = 0; i < num_polys; i++)
 				{
-					glBegin(GL_POLYGON);
-					glNormal3f(face.mPlane[0], face.mPlane[1], face.mPlane[2]);
+					PxHullPolygon face;
+					if (!mesh->getPolygonData(i, face))
+						continue;
+
+					GLuint first = (GLuint)(buffers->vertices.size() / 6);
 					const PxU8* faceIdx = indicies + face.mIndexBase;
 					for (PxU32 j = 0; j < face.mNbVerts; j++)
 					{
 						PxVec3 v = verts[faceIdx[j]];
-						glVertex3f(v.x, v.y, v.z);
+						float vertex[] = { v.x, v.y, v.z, face.mPlane[0], face.mPlane[1], face.mPlane[2] };
+						buffers->vertices.insert(buffers->vertices.end(), vertex, vertex + 6);
+					}
+
+					for (PxU32 j = 2; j < face.mNbVerts; j++)
+					{
+						buffers->indices.push_back(first);
+						buffers->indices.push_back(first + j - 1);
+						buffers->indices.push_back(first + j);
 					}
-					glEnd();
 				}
+
+				UploadMeshBuffers(buffers);
 			}
+
+			DrawMeshBuffers(buffers);
 		}
 
-		// Drawa triangle mesh
+		// Draw a triangle mesh
 		void DrawTriangleMesh(const PxGeometryHolder& geometry)
 		{
 			PxTriangleMesh* mesh = geometry.triangleMesh().triangleMesh;
-			const PxVec3* verts = mesh->getVertices();
-			PxU16* trigs = (PxU16*)mesh->getTriangles();
 			const PxU32 num_trigs = mesh->getNbTriangles();
 
-			for (PxU32 i = 0; i < num_trigs * 3; i += 3)
+			bool build;
+			MeshBuffers* buffers = FindMeshBuffers(mesh, mesh->getNbVertices(), num_trigs, build);
+
+			// First use - every corner gets the flat normal of its triangle, drawn in vertex order without indices
+			if (build)
 			{
-				PxVec3 v0 = verts[trigs[i]];
-				PxVec3 v1 = verts[trigs[i + 1]];
-				PxVec3 v2 = verts[trigs[i + 2]];
-				PxVec3 n = (v1 - v0).cross(v2 - v0);
-				n.normalize();
-				glBegin(GL_POLYGON);
-				glNormal3f(n.x, n.y, n.z);
-				glVertex3f(v0.x, v0.y, v0.z);
-				glVertex3f(v1.x, v1.y, v1.z);
-				glVertex3f(v2.x, v2.y, v2.z);
-				glEnd();
+				const PxVec3* verts = mesh->getVertices();
+				const void* trigs = mesh->getTriangles();
+				const bool short_trigs = mesh->getTriangleMeshFlags() & PxTriangleMeshFlag::e16_BIT_INDICES;
+
+				buffers->vertices.reserve(num_trigs * 3 * 6);
+				for (PxU32 i = 0; i < num_trigs * 3; i += 3)
+				{
+					PxU32 i0, i1, i2;
+					if (short_trigs)
+					{
+						const PxU16* t = (const PxU16*)trigs + i;
+						i0 = t[0]; i1 = t[1]; i2 = t[2];
+					}
+					else
+					{
+						const PxU32* t = (const PxU32*)trigs + i;
+						i0 = t[0]; i1 = t[1]; i2 = t[2];
+					}
+
+					PxVec3 v[] = { verts[i0], verts[i1], verts[i2] };
+					PxVec3 n = (v[1] - v[0]).cross(v[2] - v[0]);
+					n.normalize();
+
+					for (PxU32 j = 0; j < 3; j++)
+					{
+						float vertex[] = { v[j].x, v[j].y, v[j].z, n.x, n.y, n.z };
+						buffers->vertices.insert(buffers->vertices.end(), vertex, vertex + 6);
+					}
+				}
+
+				UploadMeshBuffers(buffers);
 			}
+
+			DrawMeshBuffers(buffers);
 		}
 
 		// Draw height field
@@ -144,16 +336,13 @@ namespace VisualDebugger
 			//TODO
 		}
 
-		// Render the diferent types of geometry
+		// Render the diferent types of geometry (boxes, spheres and capsules are instanced)
 		void RenderGeometry(const PxGeometryHolder& geometry)
 		{
 			// Switch on geometry type
 			switch(geometry.getType())
 			{
 			case PxGeometryType::ePLANE:		DrawPlane();				break;
-			case PxGeometryType::eSPHERE:		DrawSphere(geometry);		break;
-			case PxGeometryType::eBOX:			DrawBox(geometry);			break;
-			case PxGeometryType::eCAPSULE:		DrawCapsule(geometry);		break;
 			case PxGeometryType::eCONVEXMESH:	DrawConvexMesh(geometry);	break;
 			case PxGeometryType::eTRIANGLEMESH: DrawTriangleMesh(geometry); break;
 			case PxGeometryType::eHEIGHTFIELD:	DrawHeightField(geometry);	break;
@@ -162,6 +351,157 @@ namespace VisualDebugger
 			}
 		}
 
+		// Per cloth render data, kept between frames
+		struct ClothBuffers
+		{
+			// Particle positions and normals (structure of arrays, padded to a multiple of 4)
+			std::vector<float> px, py, pz;
+			std::vector<float> nx, ny, nz;
+
+			// Interleaved position / normal vertices for upload
+			std::vector<float> vertices;
+
+			// GL buffers
+			GLBuffer vertex_buffer;
+			GLBuffer index_buffer;
+
+			// Quads the index buffer was uploaded from
+			const void* quads;
+
+			// Last frame the cloth was drawn
+			PxU32 last_frame;
+
+			ClothBuffers() : index_buffer(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW), quads(0), last_frame(0) {}
+		};
+
+		// Cloth render data by cloth
+		static std::unordered_map<const PxCloth*, ClothBuffers*> cloth_buffers;
+
+		// How many frames an undrawn cloth keeps its buffers
+		static const PxU32 cloth_buffer_lifetime = 300;
+
+		// Get (or make) the render data of a cloth
+		static ClothBuffers* GetClothBuffers(const PxCloth* cloth, PxU32 particle_count)
+		{
+			ClothBuffers*& buffers = cloth_buffers[cloth];
+			if (!buffers)
+				buffers = new ClothBuffers();
+
+			// Only resized when the particle count changes
+			PxU32 padded = (particle_count + 3) & ~3;
+			if (buffers->px.size() != padded)
+			{
+				buffers->px.assign(padded, 0.0f);
+				buffers->py.assign(padded, 0.0f);
+				buffers->pz.assign(padded, 0.0f);
+				buffers->nx.assign(padded, 0.0f);
+				buffers->ny.assign(padded, 0.0f);
+				buffers->nz.assign(padded, 0.0f);
+				buffers->vertices.resize(particle_count * 6);
+			}
+
+			buffers->last_frame = frame;
+			return buffers;
+		}
+
+		// Accumulate quad normals - four quads at a time
+		static void AccumulateClothNormals(ClothBuffers* buffers, const PxU32* quads, PxU32 quad_count)
+		{
+			float* px = &buffers->px[0]; float* py = &buffers->py[0]; float* pz = &buffers->pz[0];
+			float* nx = &buffers->nx[0]; float* ny = &buffers->ny[0]; float* nz = &buffers->nz[0];
+
+			memset(nx, 0, buffers->nx.size() * sizeof(float));
+			memset(ny, 0, buffers->ny.size() * sizeof(float));
+			memset(nz, 0, buffers->nz.size() * sizeof(float));
+
+			PxU32 simd_count = quad_count & ~3;
+			for (PxU32 q = 0; q < simd_count; q += 4)
+			{
+				const PxU32* a = quads + q * 4;
+				const PxU32* b = a + 4;
+				const PxU32* c = a + 8;
+				const PxU32* d = a + 12;
+
+				// Gather the first three corners of four quads
+				__m128 x0 = _mm_setr_ps(px[a[0]], px[b[0]], px[c[0]], px[d[0]]);
+				__m128 y0 = _mm_setr_ps(py[a[0]], py[b[0]], py[c[0]], py[d[0]]);
+				__m128 z0 = _mm_setr_ps(pz[a[0]], pz[b[0]], pz[c[0]], pz[d[0]]);
+
+				__m128 ex = _mm_sub_ps(_mm_setr_ps(px[a[1]], px[b[1]], px[c[1]], px[d[1]]), x0);
+				__m128 ey = _mm_sub_ps(_mm_setr_ps(py[a[1]], py[b[1]], py[c[1]], py[d[1]]), y0);
+				__m128 ez = _mm_sub_ps(_mm_setr_ps(pz[a[1]], pz[b[1]], pz[c[1]], pz[d[1]]), z0);
+
+				__m128 fx = _mm_sub_ps(_mm_setr_ps(px[a[2]], px[b[2]], px[c[2]], px[d[2]]), x0);
+				__m128 fy = _mm_sub_ps(_mm_setr_ps(py[a[2]], py[b[2]], py[c[2]], py[d[2]]), y0);
+				__m128 fz = _mm_sub_ps(_mm_setr_ps(pz[a[2]], pz[b[2]], pz[c[2]], pz[d[2]]), z0);
+
+				// n = -(e x f)
+				PX_ALIGN(16, float) cx[4];
+				PX_ALIGN(16, float) cy[4];
+				PX_ALIGN(16, float) cz[4];
+				_mm_store_ps(cx, _mm_sub_ps(_mm_mul_ps(ez, fy), _mm_mul_ps(ey, fz)));
+				_mm_store_ps(cy, _mm_sub_ps(_mm_mul_ps(ex, fz), _mm_mul_ps(ez, fx)));
+				_mm_store_ps(cz, _mm_sub_ps(_mm_mul_ps(ey, fx), _mm_mul_ps(ex, fy)));
+
+				// Scatter to the four corners of each quad
+				for (PxU32 k = 0; k < 4; k++)
+				{
+					const PxU32* quad = a + k * 4;
+					for (PxU32 v = 0; v < 4; v++)
+					{
+						nx[quad[v]] += cx[k];
+						ny[quad[v]] += cy[k];
+						nz[quad[v]] += cz[k];
+					}
+				}
+			}
+
+			// Remaining quads
+			for (PxU32 q = simd_count; q < quad_count; q++)
+			{
+				const PxU32* quad = quads + q * 4;
+				PxVec3 v0(px[quad[0]], py[quad[0]], pz[quad[0]]);
+				PxVec3 v1(px[quad[1]], py[quad[1]], pz[quad[1]]);
+				PxVec3 v2(px[quad[2]], py[quad[2]], pz[quad[2]]);
+				PxVec3 n = -((v1 - v0).cross(v2 - v0));
+
+				for (PxU32 v = 0; v < 4; v++)
+				{
+					nx[quad[v]] += n.x;
+					ny[quad[v]] += n.y;
+					nz[quad[v]] += n.z;
+				}
+			}
+		}
+
+		// Normalise the normals - four at a time (zero length normals stay zero)
+		static void NormaliseClothNormals(ClothBuffers* buffers)
+		{
+			float* nx = &buffers->nx[0]; float* ny = &buffers->ny[0]; float* nz = &buffers->nz[0];
+			const __m128 half = _mm_set1_ps(0.5f);
+			const __m128 three_halves = _mm_set1_ps(1.5f);
+			const __m128 epsilon = _mm_set1_ps(1e-20f);
+
+			for (PxU32 i = 0; i < buffers->nx.size(); i += 4)
+			{
+				__m128 x = _mm_loadu_ps(nx + i);
+				__m128 y = _mm_loadu_ps(ny + i);
+				__m128 z = _mm_loadu_ps(nz + i);
+
+				__m128 length2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+				__m128 valid = _mm_cmpgt_ps(length2, epsilon);
+
+				// Reciprocal square root with one Newton-Raphson step
+				__m128 r = _mm_rsqrt_ps(_mm_max_ps(length2, epsilon));
+				r = _mm_mul_ps(r, _mm_sub_ps(three_halves, _mm_mul_ps(_mm_mul_ps(half, length2), _mm_mul_ps(r, r))));
+				r = _mm_and_ps(r, valid);
+
+				_mm_storeu_ps(nx + i, _mm_mul_ps(x, r));
+				_mm_storeu_ps(ny + i, _mm_mul_ps(y, r));
+				_mm_storeu_ps(nz + i, _mm_mul_ps(z, r));
+			}
+		}
+
 		// Render cloth
 		void RenderCloth(const PxCloth* cloth)
 		{
@@ -169,38 +509,48 @@ namespace VisualDebugger
 			PxVec3* color = ((UserData*)cloth->userData)->color;
 
 			PxU32 quad_count = mesh_desc->quads.count;
-			PxU32* quads = (PxU32*)mesh_desc->quads.data;
+			const PxU32* quads = (const PxU32*)mesh_desc->quads.data;
+			PxU32 particle_count = cloth->getNbParticles();
 
-			std::vector<PxVec3> verts(cloth->getNbParticles());
-			std::vector<PxVec3> norms(verts.size(), PxVec3(0.0f, 0.0f, 0.0f));
-
-			//get verts data
-			cloth->lockParticleData();
+			ClothBuffers* buffers = GetClothBuffers(cloth, particle_count);
 
+			// Copy the particle positions under a single lock
 			PxClothParticleData* particle_data = cloth->lockParticleData();
 			if (!particle_data)
 				return;
-			// copy vertex positions
-			for (PxU32 j = 0; j < verts.size(); j++)
-				verts[j] = particle_data->particles[j].pos;
+
+			const PxClothParticle* particles = particle_data->particles;
+			for (PxU32 j = 0; j < particle_count; j++)
+			{
+				buffers->px[j] = particles[j].pos.x;
+				buffers->py[j] = particles[j].pos.y;
+				buffers->pz[j] = particles[j].pos.z;
+			}
 
 			particle_data->unlock();
 
-			for (PxU32 i = 0; i < quad_count * 4; i += 4)
-			{
-				PxVec3 v0 = verts[quads[i]];
-				PxVec3 v1 = verts[quads[i + 1]];
-				PxVec3 v2 = verts[quads[i + 2]];
-				PxVec3 n = -((v1 - v0).cross(v2 - v0));
+			AccumulateClothNormals(buffers, quads, quad_count);
+			NormaliseClothNormals(buffers);
 
-				norms[quads[i]] += n;
-				norms[quads[i + 1]] += n;
-				norms[quads[i + 2]] += n;
-				norms[quads[i + 3]] += n;
+			// Interleave and upload
+			float* vertex = &buffers->vertices[0];
+			for (PxU32 j = 0; j < particle_count; j++, vertex += 6)
+			{
+				vertex[0] = buffers->px[j];
+				vertex[1] = buffers->py[j];
+				vertex[2] = buffers->pz[j];
+				vertex[3] = buffers->nx[j];
+				vertex[4] = buffers->ny[j];
+				vertex[5] = buffers->nz[j];
 			}
+			buffers->vertex_buffer.Upload(&buffers->vertices[0], buffers->vertices.size() * sizeof(float));
 
-			for (PxU32 i = 0; i < norms.size(); i++)
-				norms[i].normalize();
+			// The quads never change - upload them once
+			if (buffers->quads != quads)
+			{
+				buffers->index_buffer.Upload(quads, quad_count * 4 * sizeof(PxU32));
+				buffers->quads = quads;
+			}
 
 			PxTransform pose = cloth->getGlobalPose();
 			PxMat44 shapePose(pose);
@@ -213,10 +563,14 @@ namespace VisualDebugger
 			glEnableClientState(GL_VERTEX_ARRAY);
 			glEnableClientState(GL_NORMAL_ARRAY);
 
-			glVertexPointer(3, GL_FLOAT, sizeof(PxVec3), &verts.front());
-			glNormalPointer(GL_FLOAT, sizeof(PxVec3), &norms.front());
+			const char* base = (const char*)buffers->vertex_buffer.Bind();
+			glVertexPointer(3, GL_FLOAT, 6 * sizeof(float), base);
+			glNormalPointer(GL_FLOAT, 6 * sizeof(float), base + 3 * sizeof(float));
+
+			glDrawElements(GL_QUADS, quad_count * 4, GL_UNSIGNED_INT, buffers->index_buffer.Bind());
 
-			glDrawElements(GL_QUADS, quad_count * 4, GL_UNSIGNED_INT, quads);
+			buffers->index_buffer.Unbind();
+			buffers->vertex_buffer.Unbind();
 
 			glDisableClientState(GL_NORMAL_ARRAY);
 			glDisableClientState(GL_VERTEX_ARRAY);
@@ -224,6 +578,21 @@ namespace VisualDebugger
 			glPopMatrix();
 		}
 
+		// Free the render data of cloths that have not been drawn for a while
+		static void ReleaseStaleClothBuffers()
+		{
+			for (std::unordered_map<const PxCloth*, ClothBuffers*>::iterator it = cloth_buffers.begin(); it != cloth_buffers.end();)
+			{
+				if (frame - it->second->last_frame > cloth_buffer_lifetime)
+				{
+					delete it->second;
+					it = cloth_buffers.erase(it);
+				}
+				else
+					++it;
+			}
+		}
+
 		// Viewport reshape
 		void reshapeCallback(int width, int height)
 		{
@@ -248,7 +617,7 @@ namespace VisualDebugger
 			glutInit(&argc, argv);
 			glutInitWindowSize(glutGet(GLUT_SCREEN_WIDTH) / 2, glutGet(GLUT_SCREEN_HEIGHT) / 2);
 			glutInitWindowPosition((glutGet(GLUT_SCREEN_WIDTH) / 4), (glutGet(GLUT_SCREEN_HEIGHT) / 4));
-			glutInitDisplayMode(GLUT_RGB|GLUT_DOUBLE|GLUT_DEPTH);
+			glutInitDisplayMode(GLUT_RGB|GLUT_DOUBLE|GLUT_DEPTH|GLUT_STENCIL);
 			glutSetWindow(glutCreateWindow(name));
 			glutReshapeFunc(reshapeCallback);
 			glutIdleFunc(idleCallback);
@@ -276,18 +645,37 @@ namespace VisualDebugger
 			glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuseColor);
 			glLightfv(GL_LIGHT0, GL_POSITION, position);
 			glEnable(GL_LIGHT0);
+
+			// Buffer objects for the cloth and meshes (client arrays if the driver has none)
+			LoadBufferFunctions();
+
+			// Instanced primitives (one draw per instance if the driver can't)
+			LoadInstancingFunctions();
+
+			// BGRA colour arrays for the debug render buffer
+			const char* version = (const char*)glGetString(GL_VERSION);
+			const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+			bgra_colors = (version && version[0] >= '0' && version[0] <= '9' && version[1] == '.' && (version[0] > '3' || (version[0] == '3' && version[2] >= '2'))) ||
+				(extensions && (strstr(extensions, "GL_ARB_vertex_array_bgra") || strstr(extensions, "GL_EXT_vertex_array_bgra")));
 		}
 
 		// Start funuction
 		void Start(const PxVec3& cameraEye, const PxVec3& cameraDir)
 		{
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
 			// Setup camera
 			glMatrixMode(GL_PROJECTION);
 			glLoadIdentity();
 			gluPerspective(60.f, (float)glutGet(GLUT_WINDOW_WIDTH)/(float)glutGet(GLUT_WINDOW_HEIGHT), 1.f, 10000.f);
 
+			// Half the window height over tan(30 degrees)
+			camera_eye = cameraEye;
+			pixels_per_unit = glutGet(GLUT_WINDOW_HEIGHT) * 0.5f / 0.57735027f;
+
+			// Same volume as the projection
+			frustum.Set(cameraEye, cameraDir, 60.0f, (float)glutGet(GLUT_WINDOW_WIDTH) / (float)PxMax(glutGet(GLUT_WINDOW_HEIGHT), 1), 1.0f, 10000.0f);
+
 			glMatrixMode(GL_MODELVIEW);
 			glLoadIdentity();
 			gluLookAt(cameraEye.x, cameraEye.y, cameraEye.z, cameraEye.x + cameraDir.x, cameraEye.y + cameraDir.y, cameraEye.z + cameraDir.z, 0.f, 1.f, 0.f);
@@ -299,97 +687,361 @@ namespace VisualDebugger
 			background_color = color;
 		}
 
+		// Scale the axes of a transform
+		static PxMat44 Scaled(const PxMat44& transform, const PxVec3& scale)
+		{
+			return PxMat44(transform.column0 * scale.x, transform.column1 * scale.y, transform.column2 * scale.z, transform.column3);
+		}
+
+		// Pick the level of detail of a round shape from its projected radius - the default detail of 40 gives a slice per two pixels of radius
+		static PxU32 SelectLod(const PxVec4& position, PxReal radius)
+		{
+			PxReal distance = PxMax((PxVec3(position.x, position.y, position.z) - camera_eye).magnitude(), 1.0f);
+			PxReal slices = radius * pixels_per_unit / distance * render_detail / 80.0f;
+
+			for (PxU32 lod = 0; lod < lod_count - 1; lod++)
+			{
+				if (lod_detail[lod] >= slices)
+					return lod;
+			}
+			return lod_count - 1;
+		}
+
+		// Queue a box, sphere or capsule as instances of the unit shapes, and its shadow one level coarser when it casts one (false for other geometry)
+		static bool AddInstances(const PxGeometryHolder& geometry, const PxMat44& pose, const PxVec3& color, bool casts_shadow)
+		{
+			switch (geometry.getType())
+			{
+			case PxGeometryType::eBOX:
+				{
+					PxMat44 box = Scaled(pose, geometry.box().halfExtents);
+					instance_batches[INSTANCE_BOX][0].Add(box, color);
+					if (casts_shadow) shadow_batches[INSTANCE_BOX][0].Add(box, color);
+				}
+				return true;
+
+			case PxGeometryType::eSPHERE:
+				{
+					const PxF32 radius = geometry.sphere().radius;
+					const PxU32 lod = SelectLod(pose.column3, radius);
+
+					PxMat44 sphere = Scaled(pose, PxVec3(radius));
+					instance_batches[INSTANCE_SPHERE][lod].Add(sphere, color);
+					if (casts_shadow) shadow_batches[INSTANCE_SPHERE][lod ? lod - 1 : 0].Add(sphere, color);
+				}
+				return true;
+
+			case PxGeometryType::eCAPSULE:
+				{
+					// Two hemispheres capping a cylinder along x (the -x cap is mirrored)
+					const PxF32 radius = geometry.capsule().radius;
+					const PxF32 halfHeight = geometry.capsule().halfHeight;
+					const PxU32 lod = SelectLod(pose.column3, radius);
+
+					PxMat44 parts[3] = { pose, pose, Scaled(pose, PxVec3(halfHeight, radius, radius)) };
+					parts[0].column3 = pose.column3 + pose.column0 * halfHeight;
+					parts[0] = Scaled(parts[0], PxVec3(radius));
+					parts[1].column3 = pose.column3 - pose.column0 * halfHeight;
+					parts[1] = Scaled(parts[1], PxVec3(-radius, radius, radius));
+
+					const InstanceShape shapes[3] = { INSTANCE_HEMISPHERE, INSTANCE_HEMISPHERE, INSTANCE_CYLINDER };
+					for (PxU32 i = 0; i < 3; i++)
+					{
+						instance_batches[shapes[i]][lod].Add(parts[i], color);
+						if (casts_shadow) shadow_batches[shapes[i]][lod ? lod - 1 : 0].Add(parts[i], color);
+					}
+				}
+				return true;
+
+			default:
+				return false;
+			}
+		}
+
+		// Build the unit meshes a set of batches needs (every level is tessellated once, on first use)
+		static void BuildUnitMeshes(InstanceBatch batches[INSTANCE_SHAPE_COUNT][lod_count])
+		{
+			for (PxU32 i = 0; i < INSTANCE_SHAPE_COUNT; i++)
+			{
+				for (PxU32 lod = 0; lod < lod_count; lod++)
+				{
+					if (batches[i][lod].Size() && !unit_meshes[i][lod].detail)
+						BuildUnitMesh(unit_meshes[i][lod], (InstanceShape)i, lod_detail[lod]);
+				}
+			}
+		}
+
+		// Draw the queued instances, one draw per unit shape and level of detail
+		static void DrawInstances()
+		{
+			BuildUnitMeshes(instance_batches);
+
+			for (PxU32 i = 0; i < INSTANCE_SHAPE_COUNT; i++)
+				for (PxU32 lod = 0; lod < lod_count; lod++)
+					instance_batches[i][lod].Draw(unit_meshes[i][lod]);
+		}
+
+		// Draw every shadow in one pass after the main pass - one projection and one set of states, and the stencil lets each pixel be darkened only once
+		static void DrawShadows()
+		{
+			if (!show_shadows)
+				return;
+
+			BuildUnitMeshes(shadow_batches);
+
+			glPushMatrix();
+			glMultMatrixf(shadow_matrix);
+
+			glDisable(GL_LIGHTING);
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			glDepthMask(GL_FALSE);
+			glEnable(GL_STENCIL_TEST);
+			glStencilFunc(GL_EQUAL, 0, 0xff);
+			glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+			glColor4f(shadow_color.x, shadow_color.y, shadow_color.z, shadow_color.w);
+
+			for (PxU32 i = 0; i < shadow_casters.size(); i++)
+			{
+				glPushMatrix();
+				glMultMatrixf(shadow_casters[i].pose.front());
+				RenderGeometry(shadow_casters[i].geometry);
+				glPopMatrix();
+			}
+
+			for (PxU32 i = 0; i < INSTANCE_SHAPE_COUNT; i++)
+				for (PxU32 lod = 0; lod < lod_count; lod++)
+					shadow_batches[i][lod].Draw(unit_meshes[i][lod], &shadow_color);
+
+			glDisable(GL_STENCIL_TEST);
+			glDepthMask(GL_TRUE);
+			glDisable(GL_BLEND);
+			glEnable(GL_LIGHTING);
+
+			glPopMatrix();
+		}
+
+		// Bounds grown to cover the planar shadow on the ground when shadows are shown (shadows of shapes out of view can still fall in it)
+		static PxBounds3 WithShadow(const PxBounds3& bounds)
+		{
+			if (!show_shadows)
+				return bounds;
+
+			// The shadow matrix moves x and z along the light by the height and flattens y
+			const PxReal sx = -shadow_dir.x / shadow_dir.y;
+			const PxReal sz = -shadow_dir.z / shadow_dir.y;
+
+			PxBounds3 shadow(
+				PxVec3(bounds.minimum.x + PxMin(sx * bounds.minimum.y, sx * bounds.maximum.y), 0.0f, bounds.minimum.z + PxMin(sz * bounds.minimum.y, sz * bounds.maximum.y)),
+				PxVec3(bounds.maximum.x + PxMax(sx * bounds.minimum.y, sx * bounds.maximum.y), 0.0f, bounds.maximum.z + PxMax(sz * bounds.minimum.y, sz * bounds.maximum.y)));
+
+			PxBounds3 result = bounds;
+			result.include(shadow);
+			return result;
+		}
+
+		// Rebuild the static prop tree when the scene's static actor generation, the static shapes or the shadow setting change
+		// (the generation catches new shapes at the addresses of released ones, which the shape list alone misses)
+		static void UpdateStaticTree(PxU32 generation)
+		{
+			if (generation == static_tree_generation && frame_static_shapes == static_shapes_all && static_tree_shadows == show_shadows)
+				return;
+
+			static_shapes_all = frame_static_shapes;
+			static_tree_shadows = show_shadows;
+			static_tree_generation = generation;
+
+			static_planes.clear();
+			static_shapes.clear();
+			std::vector<PxBounds3> bounds;
+
+			for (PxU32 i = 0; i < static_shapes_all.size(); i++)
+			{
+				const PxShape* shape = static_shapes_all[i];
+
+				// Planes are unbounded
+				if (shape->getGeometryType() == PxGeometryType::ePLANE)
+				{
+					static_planes.push_back(shape);
+					continue;
+				}
+
+				static_shapes.push_back(shape);
+				bounds.push_back(WithShadow(PxShapeExt::getWorldBounds(*shape, *shape->getActor())));
+			}
+
+			static_tree.Build(bounds);
+		}
+
+		// Is a shape hidden? (a flag in its render data - trigger volumes and the like)
+		static bool Hidden(const PxShape* shape)
+		{
+			return shape->userData && (((UserData*)shape->userData)->flags & UserData::HIDDEN);
+		}
+
+		// Render a shape of a rigid actor (boxes, spheres and capsules are queued as instances) and queue its shadow when it is near enough
+		static void RenderShape(const PxShape* shape)
+		{
+			if (Hidden(shape))
+				return;
+
+			PxTransform pose = PxShapeExt::getGlobalPose(*shape, *shape->getActor());
+			PxGeometryHolder h = shape->getGeometry();
+
+			// Move the plane slightly down to avoid visual artefacts
+			if (h.getType() == PxGeometryType::ePLANE)
+			{
+				pose.q *= PxQuat(PxHalfPi, PxVec3(0.0f, 0.0f, 1.0f));
+				pose.p += PxVec3(0.0, -0.01, 0.0);
+			}
+
+			PxMat44 shapePose(pose);
+
+			PxVec3 shape_color = default_color;
+
+			if (shape->userData)
+				shape_color = *(((UserData*)shape->userData)->color);
+
+			const bool casts_shadow = show_shadows && (h.getType() != PxGeometryType::ePLANE) && (pose.p - camera_eye).magnitudeSquared() < shadow_distance * shadow_distance;
+
+			// Boxes, spheres and capsules are drawn together after the actors
+			if (AddInstances(h, shapePose, shape_color, casts_shadow))
+				return;
+
+			// Render object
+			glPushMatrix();						
+			glMultMatrixf((float*)&shapePose);
+
+			if (h.getType() == PxGeometryType::ePLANE)
+				glDisable(GL_LIGHTING);
+
+			glColor4f(shape_color.x, shape_color.y, shape_color.z, 1.0f);
+
+			RenderGeometry(h);
+
+			if (h.getType() == PxGeometryType::ePLANE)
+				glEnable(GL_LIGHTING);
+
+			glPopMatrix();
+
+			if (casts_shadow)
+			{
+				ShadowCaster caster = { shapePose, h };
+				shadow_casters.push_back(caster);
+			}
+		}
+
 		// Render the actors
-		void Render(PxActor** actors, const PxU32 numActors)
+		void Render(PxActor* const* actors, const PxU32 numActors, PxU32 generation)
 		{
-			// Shadow colour
-			PxVec3 shadow_color = default_color * 0.9;
+			for (PxU32 i = 0; i < INSTANCE_SHAPE_COUNT; i++)
+			{
+				for (PxU32 lod = 0; lod < lod_count; lod++)
+				{
+					instance_batches[i][lod].Clear();
+					shadow_batches[i][lod].Clear();
+				}
+			}
+			shadow_casters.clear();
+
+			shapes_total = 0;
+			shapes_culled = 0;
 
-			// Loop through the actors
+			// Split the actors - static props are culled through the tree, everything else one by one
+			frame_static_shapes.clear();
+			frame_actors.clear();
 			for(PxU32  i= 0; i < numActors; i++)
 			{
-				const char* name = actors[i]->getName();
-				bool contains = StringContains(name, "_inv");
-				if (contains)
-					continue;
+				if (actors[i]->getType() == PxActorType::eRIGID_STATIC)
+				{
+					PxRigidActor* rigid_actor = (PxRigidActor*)actors[i];
+					PxU32 first = (PxU32)frame_static_shapes.size();
+					frame_static_shapes.resize(first + rigid_actor->getNbShapes());
+					rigid_actor->getShapes((PxShape**)frame_static_shapes.data() + first, rigid_actor->getNbShapes());
+				}
+				else
+					frame_actors.push_back(actors[i]);
+			}
+
+			UpdateStaticTree(generation);
+
+			// Planes are always drawn
+			for (PxU32 i = 0; i < static_planes.size(); i++)
+				RenderShape(static_planes[i]);
+
+			visible_statics.clear();
+			static_tree.Query(frustum, visible_statics);
+			for (PxU32 i = 0; i < visible_statics.size(); i++)
+				RenderShape(static_shapes[visible_statics[i]]);
+
+			shapes_total += (PxU32)(static_planes.size() + static_shapes.size());
+			shapes_culled += (PxU32)(static_shapes.size() - visible_statics.size());
+
+			// Loop through the other actors
+			for (PxU32 i = 0; i < frame_actors.size(); i++)
+			{
+				PxActor* actor = frame_actors[i];
 
 				// If cloth
-				if (actors[i]->isCloth())
+				if (actor->isCloth())
 				{
-					RenderCloth((PxCloth*)actors[i]);
+					if (actor->userData && (((UserData*)actor->userData)->flags & UserData::HIDDEN))
+						continue;
+
+					shapes_total++;
+					if (frustum.Visible(WithShadow(actor->getWorldBounds())))
+						RenderCloth((PxCloth*)actor);
+					else
+						shapes_culled++;
 				}
 
 				// Else rigidbody
-				else if (actors[i]->isRigidActor())
+				else if (actor->isRigidActor())
 				{
-					PxRigidActor* rigid_actor = (PxRigidActor*)actors[i];
-					std::vector<PxShape*> shapes(rigid_actor->getNbShapes());
-					rigid_actor->getShapes((PxShape**)&shapes.front(), (PxU32)shapes.size());
+					PxRigidActor* rigid_actor = (PxRigidActor*)actor;
+					PxU32 shape_count = rigid_actor->getNbShapes();
+					if (shape_buffer.size() < shape_count)
+						shape_buffer.resize(shape_count);
+					rigid_actor->getShapes(shape_buffer.data(), shape_count);
 
-					for (PxU32 j = 0; j < shapes.size(); j++)
+					for (PxU32 j = 0; j < shape_count; j++)
 					{
-						const PxShape* shape = shapes[j];
-						PxTransform pose = PxShapeExt::getGlobalPose(*shape, *shape->getActor());
-						PxGeometryHolder h = shape->getGeometry();
-
-						// Move the plane slightly down to avoid visual artefacts
-						if (h.getType() == PxGeometryType::ePLANE)
-						{
-							pose.q *= PxQuat(PxHalfPi, PxVec3(0.0f, 0.0f, 1.0f));
-							pose.p += PxVec3(0.0, -0.01, 0.0);
-						}
-
-						PxMat44 shapePose(pose);
-
-						// Render object
-						glPushMatrix();						
-						glMultMatrixf((float*)&shapePose);
-
-						PxVec3 shape_color = default_color;
-
-						if (shape->userData)
-						{
-							shape_color = *(((UserData*)shape->userData)->color);
-							if (h.getType() == PxGeometryType::ePLANE)
-							{
-								shadow_color = shape_color * 0.9;
-							}
-						}
-
-						if (h.getType() == PxGeometryType::ePLANE)
-							glDisable(GL_LIGHTING);
-
-						glColor4f(shape_color.x, shape_color.y, shape_color.z, 1.0f);
-
-						RenderGeometry(h);
-
-						if (h.getType() == PxGeometryType::ePLANE)
-							glEnable(GL_LIGHTING);
-
-						glPopMatrix();
-
-						if (show_shadows && (h.getType() != PxGeometryType::ePLANE))
-						{
-							const PxVec3 shadowDir(-0.7071067f, -0.7071067f, -0.7071067f);
-							const PxReal shadowMat[] = { 1,0,0,0, -shadowDir.x / shadowDir.y, 0, -shadowDir.z / shadowDir.y, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
-							glPushMatrix();						
-							glMultMatrixf(shadowMat);
-							glMultMatrixf((float*)&shapePose);
-							glDisable(GL_LIGHTING);
-							glColor4f(shadow_color.x, shadow_color.y, shadow_color.z, 1.0f);
-							RenderGeometry(h);
-							glEnable(GL_LIGHTING);
-							glPopMatrix();
-						}
+						if (Hidden(shape_buffer[j]))
+							continue;
+
+						shapes_total++;
+						if (frustum.Visible(WithShadow(PxShapeExt::getWorldBounds(*shape_buffer[j], *rigid_actor))))
+							RenderShape(shape_buffer[j]);
+						else
+							shapes_culled++;
 					}
 				}
 			}
+
+			DrawInstances();
+			DrawShadows();
+		}
+
+		// Shapes culled last frame
+		PxU32 CulledShapes()
+		{
+			return shapes_culled;
+		}
+
+		// Shapes considered last frame
+		PxU32 TotalShapes()
+		{
+			return shapes_total;
 		}
 
 		// Swap buffers
 		void Finish()
 		{
 			glutSwapBuffers();
+
+			ReleaseStaleClothBuffers();
+			ReleaseStaleMeshBuffers();
+			frame++;
 		}
 
 		// Set the render detail
@@ -410,6 +1062,18 @@ namespace VisualDebugger
 			return show_shadows; 
 		}
 
+		// Set the shadow distance
+		void SetShadowDistance(PxReal value)
+		{
+			shadow_distance = value;
+		}
+
+		// Shadow distance
+		PxReal ShadowDistance()
+		{
+			return shadow_distance;
+		}
+
 		// Search for strings
 		bool StringContains(const char * search, const char * item)
 		{
@@ -426,14 +1090,32 @@ namespace VisualDebugger
 			return false;
 		}
 
-		// Render buffer
-		void RenderBuffer(float* pVertList, float* pColorList, int type, int num)
+		// Draw debug vertices straight from the render buffer - points, lines and triangles all store a position and a 0xAARRGGBB colour every 16 bytes
+		static void RenderDebugVertices(const PxDebugPoint* vertices, PxU32 count, GLenum type)
 		{
+			if (!count)
+				return;
+
+			// No BGRA arrays - swap red and blue into a copy that only grows
+			if (!bgra_colors)
+			{
+				if (debug_vertices.size() < count)
+					debug_vertices.resize(count);
+
+				for (PxU32 i = 0; i < count; i++)
+				{
+					PxU32 color = vertices[i].color;
+					debug_vertices[i].pos = vertices[i].pos;
+					debug_vertices[i].color = (color & 0xff00ff00) | ((color >> 16) & 0xff) | ((color & 0xff) << 16);
+				}
+				vertices = debug_vertices.data();
+			}
+
 			glEnableClientState(GL_VERTEX_ARRAY);
-			glVertexPointer(3,GL_FLOAT, 0, pVertList);
 			glEnableClientState(GL_COLOR_ARRAY);
-			glColorPointer(4, GL_FLOAT, 0, pColorList);
-			glDrawArrays(type, 0, num);
+			glVertexPointer(3, GL_FLOAT, sizeof(PxDebugPoint), &vertices->pos);
+			glColorPointer(bgra_colors ? GL_BGRA : 4, GL_UNSIGNED_BYTE, sizeof(PxDebugPoint), &vertices->color);
+			glDrawArrays(type, 0, count);
 			glDisableClientState(GL_COLOR_ARRAY);
 			glDisableClientState(GL_VERTEX_ARRAY);
 		}
@@ -442,113 +1124,38 @@ namespace VisualDebugger
 		//TODO: support text data
 		void Render(const PxRenderBuffer& data, PxReal line_width)
 		{
-			glLineWidth(line_width);
+			// Lines and triangles are runs of the same vertex layout as points
+			PX_COMPILE_TIME_ASSERT(sizeof(PxDebugPoint) == 16);
+			PX_COMPILE_TIME_ASSERT(sizeof(PxDebugLine) == 2 * sizeof(PxDebugPoint));
+			PX_COMPILE_TIME_ASSERT(sizeof(PxDebugTriangle) == 3 * sizeof(PxDebugPoint));
 
-			// Render points
-			unsigned int NbPoints = data.getNbPoints();
+			glLineWidth(line_width);
 
-			// If there are render points
-			if (NbPoints)
-			{
-				std::vector<float> pVertList(NbPoints * 3);
-				std::vector<float> pColorList(NbPoints * 4);
-				int vertIndex = 0;
-				int colorIndex = 0;
-				const physx::PxDebugPoint* Points = data.getPoints();
-
-				// While there are points
-				while (NbPoints--)
-				{
-					pVertList[vertIndex++] = Points->pos.x;
-					pVertList[vertIndex++] = Points->pos.y;
-					pVertList[vertIndex++] = Points->pos.z;
-					pColorList[colorIndex++] = (float)((Points->color >> 16) & 0xff) / 255.0f;
-					pColorList[colorIndex++] = (float)((Points->color >> 8) & 0xff) / 255.0f;
-					pColorList[colorIndex++] = (float)(Points->color & 0xff) / 255.0f;
-					pColorList[colorIndex++] = 1.0f;
-					Points++;
-				}
-				RenderBuffer(&pVertList.front(), &pColorList.front(), GL_POINTS, data.getNbPoints());
-			}
+			RenderDebugVertices(data.getPoints(), data.getNbPoints(), GL_POINTS);
+			RenderDebugVertices((const PxDebugPoint*)data.getLines(), data.getNbLines() * 2, GL_LINES);
+			RenderDebugVertices((const PxDebugPoint*)data.getTriangles(), data.getNbTriangles() * 3, GL_TRIANGLES);
 
-			// Render lines
-			unsigned int NbLines = data.getNbLines();
-			if (NbLines)
-			{
-				std::vector<float> pVertList(NbLines * 3 * 2);
-				std::vector<float> pColorList(NbLines * 4 * 2);
-				int vertIndex = 0;
-				int colorIndex = 0;
-				const PxDebugLine* Lines = data.getLines();
-				while(NbLines--)
-				{
-					pVertList[vertIndex++] = Lines->pos0.x;
-					pVertList[vertIndex++] = Lines->pos0.y;
-					pVertList[vertIndex++] = Lines->pos0.z;
-					pColorList[colorIndex++] = (float)((Lines->color0 >> 16) & 0xff) / 255.0f;
-					pColorList[colorIndex++] = (float)((Lines->color0 >> 8) & 0xff) / 255.0f;
-					pColorList[colorIndex++] = (float)(Lines->color0 & 0xff) / 255.0f;
-					pColorList[colorIndex++] = 1.0f;
-
-					pVertList[vertIndex++] = Lines->pos1.x;
-					pVertList[vertIndex++] = Lines->pos1.y;
-					pVertList[vertIndex++] = Lines->pos1.z;
-					pColorList[colorIndex++] = (float)((Lines->color1 >> 16) & 0xff) / 255.0f;
-					pColorList[colorIndex++] = (float)((Lines->color1 >> 8) & 0xff) / 255.0f;
-					pColorList[colorIndex++] = (float)(Lines->color1 & 0xff) / 255.0f;
-					pColorList[colorIndex++] = 1.0f;
-
-					Lines++;
-				}
+			//TODO: render texts ?
+		}
 
-				RenderBuffer(&pVertList.front(), &pColorList.front(), GL_LINES, data.getNbLines() * 2);
-			}
+		// Render a path as a line strip
+		void RenderPath(const PxVec3* points, PxU32 count, const PxVec3& color, PxReal line_width)
+		{
+			if (count < 2)
+				return;
 
-			// Render triangles
-			unsigned int NbTris = data.getNbTriangles();
-			if (NbTris)
-			{
-				std::vector<float> pVertList(NbTris * 3 * 3);
-				std::vector<float> pColorList(NbTris * 4 * 3);
-				int vertIndex = 0;
-				int colorIndex = 0;
-				const PxDebugTriangle* Triangles = data.getTriangles();
-				while (NbTris--)
-				{
-					pVertList[vertIndex++] = Triangles->pos0.x;
-					pVertList[vertIndex++] = Triangles->pos0.y;
-					pVertList[vertIndex++] = Triangles->pos0.z;
-
-					pVertList[vertIndex++] = Triangles->pos1.x;
-					pVertList[vertIndex++] = Triangles->pos1.y;
-					pVertList[vertIndex++] = Triangles->pos1.z;
-
-					pVertList[vertIndex++] = Triangles->pos2.x;
-					pVertList[vertIndex++] = Triangles->pos2.y;
-					pVertList[vertIndex++] = Triangles->pos2.z;
-
-					pColorList[colorIndex++] = (float)((Triangles->color0 >> 16) & 0xff) / 255.0f;
-					pColorList[colorIndex++] = (float)((Triangles->color0 >> 8) & 0xff) / 255.0f;
-					pColorList[colorIndex++] = (float)(Triangles->color0 & 0xff) / 255.0f;
-					pColorList[colorIndex++] = 1.0f;
-
-					pColorList[colorIndex++] = (float)((Triangles->color1 >> 16)&0xff) / 255.0f;
-					pColorList[colorIndex++] = (float)((Triangles->color1 >> 8) & 0xff) / 255.0f;
-					pColorList[colorIndex++] = (float)(Triangles->color1 & 0xff) / 255.0f;
-					pColorList[colorIndex++] = 1.0f;
-
-					pColorList[colorIndex++] = (float)((Triangles->color2 >> 16) & 0xff) / 255.0f;
-					pColorList[colorIndex++] = (float)((Triangles->color2 >> 8) & 0xff) / 255.0f;
-					pColorList[colorIndex++] = (float)(Triangles->color2 & 0xff) / 255.0f;
-					pColorList[colorIndex++] = 1.0f;
-
-					Triangles++;
-				}
+			glLineWidth(line_width);
+			glDisable(GL_LIGHTING);
+			glColor4f(color.x, color.y, color.z, 1.0f);
 
-				RenderBuffer(&pVertList.front(), &pColorList.front(), GL_TRIANGLES, data.getNbTriangles() * 3);
-			}
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glVertexPointer(3, GL_FLOAT, sizeof(PxVec3), points);
+			glDrawArrays(GL_LINE_STRIP, 0, count);
+			glDrawArrays(GL_POINTS, count - 1, 1);
+			glDisableClientState(GL_VERTEX_ARRAY);
 
-			//TODO: render texts ?
+			glEnable(GL_LIGHTING);
+			glLineWidth(1.0f);
 		}
 
 		// Render text
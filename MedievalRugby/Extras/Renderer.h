@@ -1,6 +1,9 @@
 #pragma once
 #include "GLFontRenderer.h"
 #include "UserData.h"
+#include "GLBuffer.h"
+#include "Instancing.h"
+#include "Culling.h"
 #include <GL/glut.h>
 #include <string>
 #include <iostream>
@@ -25,12 +28,21 @@ namespace VisualDebugger
 		// Start rendering a single frame
 		void Start(const PxVec3& cameraEye, const PxVec3& cameraDir);
 
-		// Render actors
-		void Render(PxActor** actors, const PxU32 numActors);
+		// Render actors (shapes flagged hidden in their UserData are skipped) - the static prop tree is rebuilt when the generation changes
+		void Render(PxActor* const* actors, const PxU32 numActors, PxU32 generation = 0);
+
+		// Shapes left out by view frustum culling in the last Render
+		PxU32 CulledShapes();
+
+		// Shapes (and cloths) the last Render considered
+		PxU32 TotalShapes();
 
 		// Render debug information
 		void Render(const PxRenderBuffer& data, PxReal line_width = 1.0f);
 
+		// Render a path as a line strip
+		void RenderPath(const PxVec3* points, PxU32 count, const PxVec3& color, PxReal line_width = 2.0f);
+
 		// Render text
 		void RenderText(const std::string& text, const physx::PxVec2& location, const PxVec3& color, PxReal size);
 
@@ -40,7 +52,7 @@ namespace VisualDebugger
 		// Finish rendering a single frame
 		void Finish();
 
-		// Set rendering detail for spheres and capsules.
+		// Set the level of detail bias for spheres and capsules (higher picks finer tessellations sooner, 40 gives a slice per two pixels of radius)
 		void SetRenderDetail(int value);
 
 		// Set show shadows
@@ -49,6 +61,12 @@ namespace VisualDebugger
 		// Get show shadows
 		bool ShowShadows();
 
+		// Set how far from the camera shapes still cast shadows
+		void SetShadowDistance(PxReal value);
+
+		// Get the shadow distance
+		PxReal ShadowDistance();
+
 		// Search for strings
 		bool StringContains(const char* search, const char* item);
 	}
@@ -1,6 +1,6 @@
 #include "UserData.h"
 
 // Constructor
-UserData::UserData(PxVec3* _color, PxClothMeshDesc* _cloth_mesh_desc) : color(_color), cloth_mesh_desc(_cloth_mesh_desc)
+UserData::UserData(PxVec3* _color, PxClothMeshDesc* _cloth_mesh_desc) : color(_color), cloth_mesh_desc(_cloth_mesh_desc), flags(0)
 {
 }
\ No newline at end of file
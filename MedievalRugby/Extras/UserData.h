@@ -8,12 +8,21 @@ using namespace physx;
 class UserData
 {
 public:
+	// Render flags
+	enum RenderFlag
+	{
+		HIDDEN = (1 << 0)
+	};
+
 	// Constructor
 	UserData(PxVec3* _color = 0, PxClothMeshDesc* _cloth_mesh_desc = 0);
 
 	// Colour
 	PxVec3* color;
 
+	// Render flags (RenderFlag bits)
+	PxU32 flags;
+
 	// Cloth mesh
 	PxClothMeshDesc* cloth_mesh_desc;
 };
\ No newline at end of file
@@ -109,15 +109,16 @@ namespace PhysicsEngine
 	void GameScene::CustomInit()
 	{
 		// Physics materials
-		longGrassMaterial	= CreateMaterial(0.75f, 0.75f, 0.25f);	// Long grass
-		shortGrassMaterial	= CreateMaterial(0.55f, 0.55f, 0.45f);	// Short grass
 		woodMaterial		= CreateMaterial(0.62f, 0.48f, 0.27f);	// Wood (oak)		
 		leatherMaterial		= CreateMaterial(0.12f, 0.52f, 0.46f);	// Leather
 		rubberMaterial		= CreateMaterial(0.61f, 0.75f, 0.82f);	// Rubber
 		concreteMaterial	= CreateMaterial(0.80f, 1.00f, 0.14f);	// Conerete
 
-		// Random seed
-		srand(time(NULL));
+		// Random seed (the scene address keeps scenes made in the same second apart)
+		random.Seed((PxU64)time(NULL) ^ (PxU64)(size_t)this);
+
+		// Entities are added by the builders
+		entities.Clear();
 
 		// Set visulisation
 		SetVisualisation();
@@ -125,39 +126,52 @@ namespace PhysicsEngine
 		px_scene->setSimulationEventCallback(collisionCallback);
 		px_scene->setFlag(PxSceneFlag::eENABLE_CCD, true);
 
-		// Build the pitch
-		BuildPitch();
-
-		// Castles
-		BuildCastle(-25.0f, -40.0f, 3.0f, color_palette[0], castle1);
-		BuildCastle(-35.0f, -20.0f, 3.0f, color_palette[2], castle2);
-		BuildCastle(20.0f,  -40.0f, 3.0f, color_palette[0], castle3);
-		BuildCastle(30.0f,  -20.0f, 3.0f, color_palette[2], castle4);
-
-		// Build the goal castle
-		BuildGoalCastle();
-
-		// Buid the teams
-		BuildTeams(5.0f);
-
-		// Build the kickers
-		BuildKickers(0.0f, 20.0f);
-
-		// Set the trampolines
-		SetTrampolines(55.0f, -20.0f);
+		// Never-moving props are merged into one static actor as the level is built
+		stadium = new StaticActor(PxTransform(PxIdentity));
+		stadium->Name("Stadium");
+
+		// Level layout - the level file when there is a valid one, the built-in layout otherwise
+		ReleaseLevel();
+		LevelFile level;
+		bool opened = level.Open(levelPath);
+		if (opened && CheckLevel(level))
+			levelStatus = levelPath;
+		else
+		{
+			levelStatus = opened ? levelPath + " incomplete, built-in" : "built-in";
+			LevelWriter defaults;
+			DefaultLevel(defaults);
+			levelImage = defaults.Image();
+			level.Open(levelImage.data(), (PxU32)levelImage.size());
+		}
+		BuildLevel(level);
 
 		// Set the balls
+		BuildBallPool(ballPoolSize);
 		SetBalls(balls);
 
-		// Set spinnsers
-		SetSpinners(-5.0f, -20.0f, 4.0f, -0.25f);
-		SetSpinners(5.0f, -45.0f, 12.0f, 0.5f);
+		// Track the moving props
+		SetRegions();
+
+		// Kicker, bouncer, firework and cannon events
+		SetTimers();
 
-		// Set the fireworks
-		SetFireWorks(20, 20.0f, -110.0f);	
+		// All never-moving props in one static actor
+		Add(stadium);
 
-		// Set the cannons
-		SetCannons(52.0f, -76.0f);
+		// Shadow scene for the trajectory preview
+		SetTrajectory();
+	}
+
+	// Custom setup once the initial actors are in the scene
+	void GameScene::CustomPostInit()
+	{
+		// Castle bricks sleep until a ball, bullet or DestroyCastle touches them (only actors in the scene can sleep)
+		for (PxU32 i = 0; i < entities.Size(); i++)
+		{
+			if (entities.kind[i] == ENTITY_BRICK && entities.body[i]->getScene())
+				entities.body[i]->putToSleep();
+		}
 	}
 
 	// Custom update function
@@ -166,36 +180,8 @@ namespace PhysicsEngine
 		// Update object count
 		objects = ObjectsCount();
 
-		// Reduce the bridge timer
-		bridgeTimer -= dt;
-		initialBridgeTimer -= dt;
-
-		// Reduce the bridge timer
-		trampTimer -= dt;
-
-		// Reduce the firework timer
-		fireworkTimer -= dt;
-
-		// Reduce the bouncer timer
-		bouncerTimer -= dt;
-
-		// Reduce the fire timer
-		fireTimer -= dt;
-
-		// Castle destroyed
-		if (castleDestroyed)
-		{
-			// Set drive velocity
-			drawBridgeJoint->DriveVelocity(1.0f);
-
-			// If timer is less than 0
-			if (bridgeTimer < 0.0f)
-			{
-				// Stop drive velocity
-				drawBridgeJoint->DriveVelocity(0.0f);
-				castleDestroyed = false;
-			}
-		}
+		// Run the timed events that fell due
+		timers.Advance(dt);
 
 		// Move bridge
 		if (!bridgeSet)
@@ -204,26 +190,30 @@ namespace PhysicsEngine
 			bridgeSet = true;
 		}
 
-		// Reset kick
-		if (kicked)
-		{
-			kickTimer -= dt;
-			if (kickTimer < 2.0f)
-			{
-				power = 30;
-				kickJoint->DriveVelocity(-1.0f);
+		// Body state of every entity in one pass
+		entities.Gather();
 
-				if (kickTimer < 0.0f && balls != 0)
-				{
-					kicked = false;
-					kickTimer = 5.0f;
-					NewBall();
-				}
-			}
-		}
+		// Recycle spent balls
+		UpdateBallPool(dt);
 
-		// Wait to reset the kicker
-		if (!kicked) { kickResetTimer -= dt; }
+		// Sleep or remove bodies that left the pitch
+		regions.Update(this, entities);
+		for (int i = 0; i < regions.Parked().size(); i++)
+			ParkBall(regions.Parked()[i]);
+
+		// Flags only get the solver time their size on screen is worth
+		flagLOD.Update();
+
+		// Predict the next kick
+		UpdateTrajectory();
+
+		// Shot map finished
+		if (shotEvaluator && shotEvaluator->Done())
+		{
+			shotStatus = shotEvaluator->Write("shot_map.csv") ? "written to shot_map.csv (moving props frozen)" : "could not write shot_map.csv";
+			delete shotEvaluator;
+			shotEvaluator = nullptr;
+		}
 
 		// Driving controls
 		if (forward && !kicked)
@@ -273,28 +263,28 @@ namespace PhysicsEngine
 		// Destroy castles
 		if (collisionCallback->castleTrigger1)
 		{
-			DestroyCastle(castle1);
+			DestroyCastle(1);
 			castleTargets[0]->Color(color_palette[3]);
 			castleTargets[0]->SetKinematic(true);
 			collisionCallback->castleTrigger1 = false;
 		}
 		if (collisionCallback->castleTrigger2)
 		{
-			DestroyCastle(castle2);
+			DestroyCastle(2);
 			castleTargets[1]->Color(color_palette[3]);
 			castleTargets[1]->SetKinematic(true);
 			collisionCallback->castleTrigger2 = false;
 		}
 		if (collisionCallback->castleTrigger3)
 		{
-			DestroyCastle(castle3);
+			DestroyCastle(3);
 			castleTargets[2]->Color(color_palette[3]);
 			castleTargets[2]->SetKinematic(true);
 			collisionCallback->castleTrigger3 = false;
 		}
 		if (collisionCallback->castleTrigger4)
 		{
-			DestroyCastle(castle4);
+			DestroyCastle(4);
 			castleTargets[3]->Color(color_palette[3]);
 			castleTargets[3]->SetKinematic(true);
 			collisionCallback->castleTrigger4 = false;
@@ -325,43 +315,6 @@ namespace PhysicsEngine
 			((PxRigidBody*)castleTargets[3]->Get())->addTorque(PxVec3(-50.0f, 0.0f, 0.0f), PxForceMode::eIMPULSE);
 			collisionCallback->targethit4Blue = false;
 		}
-
-		// Reset the firworks
-		if (fireworkTimer < 0.0f)
-		{
-			for (int i = 0; i < fireworks1.size(); i++)
-			{
-				((PxRigidBody*)fireworks1[i]->Get())->setGlobalPose(PxTransform(PxVec3(-20.0f, 1.0f * i, -110.0f)));
-				((PxRigidBody*)fireworks2[i]->Get())->setGlobalPose(PxTransform(PxVec3(20.0f, 1.0f * i, -110.0f)));
-			}
-		}
-
-		// Reset the firworks
-		if (bouncerTimer < 0.0f)
-		{
-			((PxRigidBody*)bouncer1->Get())->setGlobalPose(PxTransform(PxVec3(-55.0f, 50.0f, -20.0f)));
-			((PxRigidBody*)bouncer2->Get())->setGlobalPose(PxTransform(PxVec3(55.0f, 50.0f, -20.0f)));
-
-			bouncerTimer = 15.0f;
-		}
-
-		// Reset the fire cannons
-		if (fireTimer < 4.5f)
-		{
-			if (!fired)
-			{
-				FireCannons();
-				fired = true;
-			}
-
-			if (fireTimer < 0.0f)
-			{
-				((PxRigidBody*)bullet1->Get())->setGlobalPose(PxTransform(PxVec3(-52.0f, 19.0f, -76.0f)));
-				((PxRigidBody*)bullet2->Get())->setGlobalPose(PxTransform(PxVec3(52.0f, 21.0f, -76.0f)));
-				bullet1->SetKinematic(true);
-				bullet2->SetKinematic(true);
-			}
-		}
 	}
 
 	// Get the score
@@ -370,6 +323,13 @@ namespace PhysicsEngine
 		return score;
 	}
 
+	// Predicted flight of the loaded ball
+	const TrajectoryPath* GameScene::Trajectory()
+	{
+		if (!trajectory.Running() || kicked || loadedBall == -1) return nullptr;
+		return &trajectory.Latest();
+	}
+
 	// Get the shot power
 	float GameScene::Power()
 	{
@@ -394,6 +354,24 @@ namespace PhysicsEngine
 		return castlesDestroyed;
 	}
 
+	// Get the castles a team destroyed
+	int GameScene::DestroyedCastles(EntityTeam team)
+	{
+		return teamCastlesDestroyed[team];
+	}
+
+	// Get the bodies asleep out of bounds
+	int GameScene::OutOfBoundsAsleep()
+	{
+		return regions.Sleeping();
+	}
+
+	// Get the bodies removed out of bounds
+	int GameScene::OutOfBoundsRemoved()
+	{
+		return regions.Removed();
+	}
+
 	// An example use of key release handling
 	void GameScene::KeyReleaseHandler(int key)
 	{
@@ -418,13 +396,17 @@ namespace PhysicsEngine
 		if (key == 'V')
 		{
 			// Shoot the ball
-			if (kickJoint->DriveVelocity() == -1.0f && kickResetTimer <= 0.0f)
+			if (kickJoint->DriveVelocity() == -1.0f && kickReady)
 			{
 				kickJoint->DriveVelocity(power / 10.0f);
 				kicked = true;
-				kickResetTimer = 4.0f;
+				kickReady = false;
 				SetBallPose();
 				FireCannons();
+
+				// Arm back after 3 seconds, next ball after 5
+				timers.Schedule(3.0f, [this]() { ReturnKicker(); });
+				timers.Schedule(5.0f, [this]() { ReloadKicker(); });
 			}
 		}
 
@@ -439,6 +421,24 @@ namespace PhysicsEngine
 		{
 			SetBalls(10);
 		}
+
+		// Build the shot map
+		if (key == 'K')
+		{
+			EvaluateShots();
+		}
+
+		// Write the built-in layout as a starting point for new levels
+		if (key == 'L')
+		{
+			SaveDefaultLevel("level_default.mrl");
+		}
+
+		// Benchmark the update at 1000 entities
+		if (key == 'X')
+		{
+			SpawnDebris(1000);
+		}
 	}
 
 	// An example use of key presse handling
@@ -452,48 +452,41 @@ namespace PhysicsEngine
 	}
 
 	// Build castle
-	void GameScene::BuildCastle(float xOffset, float zOffset, float targetOffset, PxVec3 colour, vector<Box*>& castle)
+	void GameScene::BuildCastle(float xOffset, float zOffset, float targetOffset, PxVec3 colour, int castle)
 	{
-		// Build castle brick by brick
-		for (int x = 0; x < 3; x++)
+		// One broadphase entry per castle
+		Aggregate* group = useAggregates ? new Aggregate(32, castleSelfCollision) : 0;
+
+		// Target filtering - only balls of one team can knock the target over
+		FilterGroup::Enum filterGroup;
+		FilterGroup::Enum filterGroupBall;
+		switch (castleIndex)
 		{
-			for (int y = 1; y < 4; y++)
-			{
-				for (int z = 0; z < 3; z++)
-				{
-					if (y == 3 && (abs(x) % 2 != 1 && (z == 0 || z == 2)) || (abs(z) % 2 != 1 && (x == 0 || x == 2)))
-					{
-						Box* box = new Box(PxTransform(PxVec3(xOffset + (3.0f * x), 0.0f + (3.0f * y), zOffset + (3.0f * z))), PxVec3(1.5f, 1.5f, 1.5f));
-						box->Color(color_palette[5]);
-						box->Material(concreteMaterial);
-						Add(box);
-						castle.push_back(box);
-					}
-					else if (y < 3 && (x == 0 || x == 2))
-					{
-						Box* box = new Box(PxTransform(PxVec3(xOffset + (3.0f * x), 0.0f + (3.0f * y), zOffset + (3.0f * z))), PxVec3(1.5f, 1.5f, 1.5f));
-						box->Color(color_palette[5]);
-						box->Material(concreteMaterial);
-						Add(box);
-						castle.push_back(box);
-					}
-					else if (y < 3 && (z == 0 || z == 2))
-					{
-						Box* box = new Box(PxTransform(PxVec3(xOffset + (3.0f * x), 0.0f + (3.0f * y), zOffset + (3.0f * z))), PxVec3(1.5f, 1.5f, 1.5f));
-						box->Color(color_palette[5]);
-						box->Material(concreteMaterial);
-						Add(box);
-						castle.push_back(box);
-					}
-				}
-			}
+		case 1: filterGroup = FilterGroup::CASTLE_TARGET_1; filterGroupBall = FilterGroup::RED_BALL; break;
+		case 2: filterGroup = FilterGroup::CASTLE_TARGET_2; filterGroupBall = FilterGroup::BLUE_BALL; break;
+		case 3: filterGroup = FilterGroup::CASTLE_TARGET_3; filterGroupBall = FilterGroup::RED_BALL; break;
+		case 4: filterGroup = FilterGroup::CASTLE_TARGET_4; filterGroupBall = FilterGroup::BLUE_BALL; break;
+		}
+
+		// Build castle brick by brick - already settled (put to sleep in CustomPostInit), on the team whose balls can hit the target
+		EntityTeam team = filterGroupBall == FilterGroup::RED_BALL ? TEAM_RED : TEAM_BLUE;
+		const vector<PxTransform>& rest_poses = CastleRestPoses();
+		vector<Box*> bricks;
+		for (PxU32 i = 0; i < rest_poses.size(); i++)
+		{
+			Box* box = new Box(PxTransform(PxVec3(xOffset, 0.0f, zOffset)) * rest_poses[i], PxVec3(1.5f, 1.5f, 1.5f));
+			box->Color(color_palette[5]);
+			box->Material(concreteMaterial);
+			bricks.push_back(box);
+			entities.Add(box, ENTITY_BRICK, team, (PxU16)castle);
 		}
+		AddRange(bricks, group);
 
 		// Target
 		target = new Target(PxTransform(PxVec3(xOffset + targetOffset, 5.0f, zOffset + 3.0f)), PxVec3(5.0f, 5.0f, 5.0f));
 		target->Color(PxVec3(1.0f, 1.0f, 1.0f));
-		target->SetKinematic(true);
 		target->Name("Target");
+		target->Bake();
 		Add(target);
 
 		// Castle target box
@@ -502,32 +495,102 @@ namespace PhysicsEngine
 		castleTargets.back()->SetKinematic(true);
 		((PxRigidBody*)castleTargets.back()->Get())->setMass(0.25f);
 		castleTargets.back()->Name("TargetBox" + to_string(castleTargets.size() - 1));
-		Add(castleTargets.back());
+		Add(castleTargets.back(), group);
 
 		// Filtering
-		FilterGroup::Enum filterGroup;
-		FilterGroup::Enum filterGroupBall;
-		switch (castleIndex)
-		{
-		case 1: filterGroup = FilterGroup::CASTLE_TARGET_1; filterGroupBall = FilterGroup::RED_BALL; break;
-		case 2: filterGroup = FilterGroup::CASTLE_TARGET_2; filterGroupBall = FilterGroup::BLUE_BALL; break;
-		case 3: filterGroup = FilterGroup::CASTLE_TARGET_3; filterGroupBall = FilterGroup::RED_BALL; break;
-		case 4: filterGroup = FilterGroup::CASTLE_TARGET_4; filterGroupBall = FilterGroup::BLUE_BALL; break;
-		}
 		castleTargets.back()->SetupFiltering(filterGroup, filterGroupBall);
 		castleIndex++;
 
 		// Trigger box
 		castleTriggers.push_back(new Box(PxTransform(PxVec3(xOffset + targetOffset, 10.5f, zOffset - 1.5f))));
 		castleTriggers.back()->Name("TriggerBox_inv" + to_string(castleTargets.size() - 1));
-		castleTriggers.back()->SetKinematic(true);
 		castleTriggers.back()->SetTrigger(true);
+		castleTriggers.back()->Visible(false);
+		castleTriggers.back()->Bake();
 		Add(castleTriggers.back());
+		if (group) Add(group);
 
 		// Castle target joint
 		targetJoints.push_back(new RevoluteJoint(target, PxTransform(PxVec3(0.0f, 5.25f, 0.0f), PxQuat(PxPi * 2.0f, PxVec3(1.0f, 0.0f, 0.0f))), castleTargets.back(), PxTransform(PxVec3(0.0f, -5.0f, 0.0f))));
 	}
 
+	// Castle brick positions on the 3m grid, relative to the castle corner
+	vector<PxVec3> GameScene::CastleLayout()
+	{
+		vector<PxVec3> layout;
+		for (int x = 0; x < 3; x++)
+		{
+			for (int y = 1; y < 4; y++)
+			{
+				for (int z = 0; z < 3; z++)
+				{
+					// Battlements, side walls and front / back walls
+					if ((y == 3 && (abs(x) % 2 != 1 && (z == 0 || z == 2)) || (abs(z) % 2 != 1 && (x == 0 || x == 2)))
+						|| (y < 3 && (x == 0 || x == 2))
+						|| (y < 3 && (z == 0 || z == 2)))
+						layout.push_back(PxVec3(3.0f * x, 3.0f * y, 3.0f * z));
+				}
+			}
+		}
+		return layout;
+	}
+
+	// Castle brick rest poses - settled once in a scratch scene and shared by every castle and game scene
+	const vector<PxTransform>& GameScene::CastleRestPoses()
+	{
+		static vector<PxTransform> rest_poses;
+		if (rest_poses.size())
+			return rest_poses;
+
+		// Scratch scene
+		PxSceneDesc sceneDesc(GetPhysics()->getTolerancesScale());
+		PxDefaultCpuDispatcher* dispatcher = PxDefaultCpuDispatcherCreate(1);
+		sceneDesc.cpuDispatcher = dispatcher;
+		sceneDesc.filterShader = PxDefaultSimulationFilterShader;
+		sceneDesc.gravity = PxVec3(0.0f, -9.81f, 0.0f);
+		PxScene* settle = GetPhysics()->createScene(sceneDesc);
+		if (!settle) throw new Exception("GameScene::CastleRestPoses, Could not create the settle scene.");
+
+		// Ground at the top of the pitch boxes
+		PxRigidStatic* ground = PxCreatePlane(*GetPhysics(), PxPlane(PxVec3(0.0f, 1.0f, 0.0f), -1.0f), *concreteMaterial);
+		settle->addActor(*ground);
+
+		// Bricks on the layout grid
+		vector<PxVec3> layout = CastleLayout();
+		vector<PxRigidDynamic*> bricks;
+		for (PxU32 i = 0; i < layout.size(); i++)
+		{
+			bricks.push_back(PxCreateDynamic(*GetPhysics(), PxTransform(layout[i]), PxBoxGeometry(1.5f, 1.5f, 1.5f), *concreteMaterial, 1.0f));
+			settle->addActor(*bricks.back());
+		}
+
+		// Step until every brick is asleep (10 seconds at most)
+		for (int step = 0; step < 600; step++)
+		{
+			settle->simulate(1.0f / 60.0f);
+			settle->fetchResults(true);
+
+			bool asleep = true;
+			for (PxU32 i = 0; i < bricks.size() && asleep; i++)
+				asleep = bricks[i]->isSleeping();
+			if (asleep) break;
+		}
+
+		// Capture the rest poses
+		for (PxU32 i = 0; i < bricks.size(); i++)
+		{
+			rest_poses.push_back(bricks[i]->getGlobalPose());
+			bricks[i]->release();
+		}
+
+		// Release the scratch scene
+		ground->release();
+		settle->release();
+		dispatcher->release();
+
+		return rest_poses;
+	}
+
 	// Build team
 	void GameScene::BuildTeams(float zOffset)
 	{
@@ -538,111 +601,32 @@ namespace PhysicsEngine
 			playersRed.back()->Color(PxVec3(1.0f, 0.0f, 0.0f));
 			((PxRigidBody*)playersRed.back()->Get())->setMass(100.0f);
 			playersRed.back()->Name("PlayerRed" + i);
-			playersRed.back()->SetKinematic(true);
-			Add(playersRed.back());
+			playersRed.back()->MergeInto(stadium);
 			upJavalin = !upJavalin;
 		}
 	}
 
-	// Build the pitch
-	void GameScene::BuildPitch()
-	{
-		// Plane 
-		plane = new Plane();
-		plane->Color(PxVec3(0.0f, 0.0f, 1.0f));
-		Add(plane);
-
-		// Pitch lines
-		pitchLines = new PitchLines();
-		pitchLines->Color(color_palette[3]);
-		pitchLines->SetKinematic(true);
-		pitchLines->Name("PitchLines");
-		Add(pitchLines);
-
-		// Pitch grass
-		pitchBottomLeft = new Box(PxTransform(PxVec3(-34.875f, 0.0f, 30.0f)), PxVec3(34.875f, 1.0f, 29.75f));
-		pitchBottomLeft->Color(color_palette[1] / 2.0f);
-		pitchBottomLeft->SetKinematic(true);
-		pitchBottomLeft->Name("PitchBottomLeft");
-		pitchBottomLeft->Material(longGrassMaterial);
-		Add(pitchBottomLeft);
-
-		pitchBottomRight = new Box(PxTransform(PxVec3(34.875f, 0.0f, 30.0f)), PxVec3(34.875f, 1.0f, 29.75f));
-		pitchBottomRight->Color(color_palette[1]);
-		pitchBottomRight->SetKinematic(true);
-		pitchBottomRight->Name("PitchBottomRight");
-		pitchBottomRight->Material(shortGrassMaterial);
-		Add(pitchBottomRight);
-
-		pitchTopLeft = new Box(PxTransform(PxVec3(34.875f, 0.0f, -30.0f)), PxVec3(34.875f, 1.0f, 29.75f));
-		pitchTopLeft->Color(color_palette[1] / 2.0f);
-		pitchTopLeft->SetKinematic(true);
-		pitchTopLeft->Name("PitchTopLeft");
-		pitchTopLeft->Material(longGrassMaterial);
-		Add(pitchTopLeft);
-
-		pitchTopRight = new Box(PxTransform(PxVec3(-34.875f, 0.0f, -30.0f)), PxVec3(34.875f, 1.0f, 29.75f));
-		pitchTopRight->Color(color_palette[1]);
-		pitchTopRight->SetKinematic(true);
-		pitchTopRight->Name("PitchTopRight");
-		pitchTopRight->Material(shortGrassMaterial);
-		Add(pitchTopRight);
-
-		pitchTopGoal = new Box(PxTransform(PxVec3(0.0f, 0.0f, -90.0f)), PxVec3(69.75f, 1.0f, 9.75f));
-		pitchTopGoal->Color(color_palette[1]);
-		pitchTopGoal->SetKinematic(true);
-		pitchTopGoal->Name("PitchTopGoal");
-		Add(pitchTopGoal);
-
-		pitchBottomGoal = new Box(PxTransform(PxVec3(0.0f, 0.0f, 90.0f)), PxVec3(69.75f, 1.0f, 9.75f));
-		pitchBottomGoal->Color(color_palette[1]);
-		pitchBottomGoal->SetKinematic(true);
-		pitchBottomGoal->Name("PitchBottomGoal");
-		Add(pitchBottomGoal);
-
-		// Posts
-		posts = new Post();
-		posts->Color(PxVec3(1.0f, 1.0f, 1.0f));
-		posts->SetKinematic(true);
-		posts->Name("Posts");
-		Add(posts);
-
-		// Goal collision
-		goalCollisionShape = new Box(PxTransform(PxVec3(0.0f, 40.25f, -85.5f)), PxVec3(5.0f, 30.0f, 0.1f));
-		goalCollisionShape->SetKinematic(true);
-		goalCollisionShape->SetTrigger(true);
-		goalCollisionShape->Name("GoalTrigger_inv");
-		//goalCollisionShape->GetShape()->setFlag(PxShapeFlag::eVISUALIZATION, false);
-		Add(goalCollisionShape);
-	}
-
-	// Build the goadl castle
-	void GameScene::BuildGoalCastle()
-	{
-		// Wall
-		wall = new Wall(PxTransform(PxVec3(0.0f, 10.0f, -80.0f)), PxVec3(70.0f, 10.0f, 2.5f));
-		wall->Color(color_palette[5]);
-		wall->SetKinematic(true);
-		wall->Material(concreteMaterial);
-		wall->Name("Wall");
-		Add(wall);
-
+	// Build the goal castle (the wall and flag poles are level props)
+	void GameScene::BuildGoalCastle(float xOffset, float zOffset)
+	{
 		// Bridge
-		bridge = new Drawbridge(PxTransform(PxVec3(0.0f, 1.5f, -55.0f), PxQuat(-PxPi / 2.0f, PxVec3(1.0f, 0.0f, 0.0f))), PxVec3(12.25f, 12.5f, 0.5f));
+		bridge = new Drawbridge(PxTransform(PxVec3(xOffset, 1.5f, zOffset - 55.0f), PxQuat(-PxPi / 2.0f, PxVec3(1.0f, 0.0f, 0.0f))), PxVec3(12.25f, 12.5f, 0.5f));
 		bridge->Color(color_palette[0]);
 		bridge->SetKinematic(false);
 		bridge->Material(woodMaterial);
 		bridge->Name("Bridge");
 		Add(bridge);
+		shotProps.push_back(bridge);
 
-		drawBridgeJoint = new RevoluteJoint(nullptr, PxTransform(PxVec3(0.0f, 1.5f, -80.0f), PxQuat(-PxPi / 2.0f, PxVec3(1.0f, 0.0f, 0.0f))), bridge, PxTransform(PxVec3(0.0f, 25.0f, 0.0f)));
+		drawBridgeJoint = new RevoluteJoint(nullptr, PxTransform(PxVec3(xOffset, 1.5f, zOffset - 80.0f), PxQuat(-PxPi / 2.0f, PxVec3(1.0f, 0.0f, 0.0f))), bridge, PxTransform(PxVec3(0.0f, 25.0f, 0.0f)));
 		drawBridgeJoint->DriveVelocity(1.5f);
 		drawBridgeJoint->SetLimits(-PxPi / 2.0f, -0.025f);
 
 		// Flags
+		flagLOD.Clear();
 		for (int i = 0; i < 2; i++)
 		{
-			flag = new Cloth(PxTransform(PxVec3(-70.0f + (140.0f * i), 30.0f, -80.0f), PxQuat(3.0f * PxPi / 6.0f, PxVec3(0.0f, 0.0f, 1.0f))), PxVec2(15.0f, 15.0f), 20, 20);
+			flag = new Cloth(PxTransform(PxVec3(xOffset - 70.0f + (140.0f * i), 30.0f, zOffset - 80.0f), PxQuat(3.0f * PxPi / 6.0f, PxVec3(0.0f, 0.0f, 1.0f))), PxVec2(15.0f, 15.0f), 20, 20);
 			flag->Color(color_palette[0]);
 			flag->Name("Flag");
 			Add(flag);
@@ -654,25 +638,23 @@ namespace PhysicsEngine
 			((PxCloth*)flag->Get())->setSelfCollisionStiffness(1.0f);
 			((PxCloth*)flag->Get())->setClothFlag(PxClothFlag::eSWEPT_CONTACT, true);
 			((PxCloth*)flag->Get())->setExternalAcceleration(PxVec3(5.0f + (i * -10.0f), 1.25f, 0.0f));
-
-			flagPole = new Box(PxTransform(PxVec3(-70.0f + (140.0f * i), 35.0f, -80.0f)), PxVec3(0.25f, 10.0f, 0.25f));
-			flagPole->SetKinematic(true);
-			flagPole->Color(color_palette[3]);
-			flag->Name("FlagPole");
-			Add(flagPole);
+			flagLOD.Track(flag);
 		}
 	}
 
 	// Build the kickers
 	void GameScene::BuildKickers(float xOffset, float zOffset)
 	{
+		// Base, arm and wheels share one broadphase entry - the joints keep them apart
+		Aggregate* group = useAggregates ? new Aggregate(6, kickerSelfCollision) : 0;
+
 		// Base
 		kickerBase = new KickerBase(PxTransform(PxVec3(0.0f, 3.5f, zOffset)), PxVec3(5.0f, 3.0f, 3.0f));
 		kickerBase->Color(color_palette[6]);
 		((PxRigidBody*)kickerBase->Get())->setMass(150.0f);
 		kickerBase->Material(woodMaterial);
 		kickerBase->Name("KickerBase");
-		Add(kickerBase);
+		Add(kickerBase, group);
 
 		// Kick
 		kicker = new Kicker(PxTransform(PxVec3(-xOffset, 11.375f, zOffset), PxQuat(-PxPi / 2.0f, (PxVec3(1.0f, 0.0f, 0.0f)))), PxVec3(5.0f, 3.0f, 3.3f));
@@ -680,7 +662,7 @@ namespace PhysicsEngine
 		kicker->Material(woodMaterial);
 		((PxRigidBody*)kicker->Get())->setRigidBodyFlag(PxRigidBodyFlag::eENABLE_CCD, true);
 		kicker->Name("Kicker");
-		Add(kicker);
+		Add(kicker, group);
 
 		// Kick joint
 		kickJoint = new RevoluteJoint(kickerBase, PxTransform(PxVec3(0.0f, 6.0f, 0.0f), PxQuat(PxPi * 2, PxVec3(0.0f, 0.0f, 1.0f))), kicker, PxTransform(PxVec3(0.0f, 0.0f, -3.3f)));
@@ -692,7 +674,7 @@ namespace PhysicsEngine
 		wheelFL = new Wheel(PxTransform(PxVec3(-5.5f, 3.5f, -5.0f + zOffset)));
 		wheelFL->mesh->Color(color_palette[6]);
 		wheelFL->mesh->Material(woodMaterial);
-		Add(wheelFL->mesh);
+		Add(wheelFL->mesh, group);
 		wheelJointFL = new RevoluteJoint(kickerBase, PxTransform(PxVec3(-5.25f, -0.5f, -5.0f)), wheelFL->mesh, PxTransform(PxVec3(0.0f, 0.0f, 0.0f)));
 		wheelJointFL->DriveVelocity(0.0f);
 
@@ -700,7 +682,7 @@ namespace PhysicsEngine
 		wheelFR = new Wheel(PxTransform(PxVec3(5.5f, 3.5f, -5.0f + zOffset)));
 		wheelFR->mesh->Color(color_palette[6]);
 		wheelFR->mesh->Material(woodMaterial);
-		Add(wheelFR->mesh);
+		Add(wheelFR->mesh, group);
 		wheelJointFR = new RevoluteJoint(kickerBase, PxTransform(PxVec3(5.25f, -0.5f, -5.0f)), wheelFR->mesh, PxTransform(PxVec3(0.0f, 0.0f, 0.0f)));
 		wheelJointFR->DriveVelocity(0.0f);
 
@@ -708,7 +690,7 @@ namespace PhysicsEngine
 		wheelBL = new Wheel(PxTransform(PxVec3(-5.5f, 3.5f, 5.0f + zOffset)));
 		wheelBL->mesh->Color(color_palette[6]);
 		wheelBL->mesh->Material(woodMaterial);
-		Add(wheelBL->mesh);
+		Add(wheelBL->mesh, group);
 		wheelJointBL = new RevoluteJoint(kickerBase, PxTransform(PxVec3(-5.25f, -0.5f, 5.0f)), wheelBL->mesh, PxTransform(PxVec3(0.0f, 0.0f, 0.0f)));
 		wheelJointBL->DriveVelocity(0.0f);
 
@@ -716,21 +698,37 @@ namespace PhysicsEngine
 		wheelBR = new Wheel(PxTransform(PxVec3(5.5f, 3.5f, 5.0f + zOffset)));
 		wheelBR->mesh->Color(color_palette[6]);
 		wheelBR->mesh->Material(woodMaterial);
-		Add(wheelBR->mesh);
+		Add(wheelBR->mesh, group);
 		wheelJointBR = new RevoluteJoint(kickerBase, PxTransform(PxVec3(5.25f, -0.5f, 5.0f)), wheelBR->mesh, PxTransform(PxVec3(0.0f, 0.0f, 0.0f)));
 		wheelJointBR->DriveVelocity(0.0f);
+
+		if (group) Add(group);
 	}
 
-	// Set the balls
-	void GameScene::SetBalls(int balls)
+	// Build the ball pool
+	void GameScene::BuildBallPool(int size)
 	{
-		// Set the balls
-		for (int i = 0; i < balls; i++)
+		// Free the last pool - a reset has taken its balls out of the scene, parked ones were never in it
+		PxConvexMesh* hull = ball.size() ? ball[0]->Hull() : 0;
+		for (PxU32 i = 0; i < ball.size(); i++)
+		{
+			PxActor* actor = ball[i]->mesh->Get();
+			delete ball[i]->mesh;
+			actor->release();
+			delete ball[i];
+		}
+		if (hull) hull->release();
+		ball.clear();
+		ballFirst = entities.Size();
+		loadedBall = -1;
+
+		// Create the balls - only the first one cooks a hull
+		for (int i = 0; i < size; i++)
 		{
-			ball.push_back(new Ball(PxTransform(PxVec3(20.0f + (2.0f * i), 3.5f, 5.0f), PxQuat(PxPi / 2.0f, (PxVec3(1.0f, 0.0f, 0.0f))))));
+			if (i == 0) ball.push_back(new Ball(PxTransform(PxIdentity)));
+			else ball.push_back(new Ball(ball[0]->Hull(), PxTransform(PxIdentity)));
 
 			((PxRigidBody*)ball.back()->mesh->Get())->setMass(0.45f);
-			Add(ball.back()->mesh);
 
 			if (i % 2 == 0)
 			{
@@ -748,6 +746,95 @@ namespace PhysicsEngine
 			}
 
 			ball.back()->mesh->Get()->isRigidBody()->setRigidBodyFlag(PxRigidBodyFlag::eENABLE_CCD, true);
+
+			// Parked until needed (the pool slot is the group)
+			PxU32 entity = entities.Add(ball.back()->mesh, ENTITY_BALL, i % 2 == 0 ? TEAM_BLUE : TEAM_RED, (PxU16)i);
+			entities.state[entity] = BALL_PARKED;
+		}
+	}
+
+	// Get a parked ball, or recycle the oldest spent one
+	int GameScene::AcquireBall()
+	{
+		const PxU8* state = entities.state.data() + ballFirst;
+		const PxReal* spent = entities.timer.data() + ballFirst;
+		int oldest = -1;
+		for (int i = 0; i < ball.size(); i++)
+		{
+			if (state[i] == BALL_PARKED)
+				return i;
+
+			if (state[i] == BALL_SPENT && (oldest == -1 || spent[i] > spent[oldest]))
+				oldest = i;
+		}
+		return oldest;
+	}
+
+	// Put a pooled ball in the scene
+	void GameScene::ActivateBall(int index, const PxTransform& pose, BallState state)
+	{
+		PxU32 entity = ballFirst + index;
+		PxRigidDynamic* actor = entities.body[entity];
+
+		// Parked balls are out of the scene - set the pose directly
+		if (entities.state[entity] == BALL_PARKED)
+		{
+			actor->setGlobalPose(pose);
+			actor->setLinearVelocity(PxVec3(0.0f, 0.0f, 0.0f));
+			actor->setAngularVelocity(PxVec3(0.0f, 0.0f, 0.0f));
+			Add(ball[index]->mesh);
+		}
+
+		// Recycled balls are still in the scene
+		else
+		{
+			pose_batch.Pose(actor, pose);
+			pose_batch.Velocity(actor, PxVec3(0.0f, 0.0f, 0.0f), PxVec3(0.0f, 0.0f, 0.0f));
+		}
+
+		entities.state[entity] = (PxU8)state;
+		entities.timer[entity] = 0.0f;
+	}
+
+	// Take a pooled ball out of the scene
+	void GameScene::ParkBall(int index)
+	{
+		PxU32 entity = ballFirst + index;
+		if (entities.state[entity] == BALL_PARKED)
+			return;
+
+		Remove(ball[index]->mesh);
+		entities.state[entity] = BALL_PARKED;
+		entities.flags[entity] = 0;
+		if (loadedBall == index) loadedBall = -1;
+	}
+
+	// Park spent balls once they have settled or timed out
+	void GameScene::UpdateBallPool(PxReal dt)
+	{
+		PxU8* state = entities.state.data() + ballFirst;
+		PxReal* spent = entities.timer.data() + ballFirst;
+		const PxU8* flags = entities.flags.data() + ballFirst;
+		for (int i = 0; i < ball.size(); i++)
+		{
+			if (state[i] != BALL_SPENT)
+				continue;
+
+			spent[i] += dt;
+			if (spent[i] > spentBallLifetime || (flags[i] & ENTITY_SLEEPING))
+				ParkBall(i);
+		}
+	}
+
+	// Set the balls
+	void GameScene::SetBalls(int balls)
+	{
+		// Rack the balls from the pool
+		for (int i = 0; i < balls; i++)
+		{
+			int index = AcquireBall();
+			if (index == -1) break;
+			ActivateBall(index, PxTransform(PxVec3(20.0f + (2.0f * i), 3.5f, 5.0f), PxQuat(PxPi / 2.0f, (PxVec3(1.0f, 0.0f, 0.0f)))), BALL_RACKED);
 		}
 	}
 
@@ -757,6 +844,30 @@ namespace PhysicsEngine
 		if (balls > 0)
 		{
 			balls--;
+
+			// The kicked ball is spent
+			if (loadedBall != -1 && entities.state[ballFirst + loadedBall] == BALL_LOADED)
+			{
+				entities.state[ballFirst + loadedBall] = BALL_SPENT;
+				entities.timer[ballFirst + loadedBall] = 0.0f;
+			}
+
+			// Take the last racked ball, else recycle one
+			loadedBall = -1;
+			for (int i = (int)ball.size() - 1; i >= 0 && loadedBall == -1; i--)
+			{
+				if (entities.state[ballFirst + i] == BALL_RACKED)
+					loadedBall = i;
+			}
+			if (loadedBall == -1)
+			{
+				loadedBall = AcquireBall();
+				if (loadedBall != -1)
+					ActivateBall(loadedBall, ((PxRigidBody*)kickerBase->Get())->getGlobalPose(), BALL_LOADED);
+			}
+			if (loadedBall != -1)
+				entities.state[ballFirst + loadedBall] = BALL_LOADED;
+
 			SetBallPose();
 			newBall = false;
 		}
@@ -765,26 +876,51 @@ namespace PhysicsEngine
 	// Set ball pose
 	void GameScene::SetBallPose()
 	{
+		// No ball on the kicker
+		if (loadedBall == -1) return;
+
 		PxVec3 pos = ((PxRigidBody*)kickerBase->Get())->getGlobalPose().p;
 		PxTransform transform = PxTransform(PxVec3(pos.x, pos.y + 0.0f, pos.z), PxQuat(PxPi / 2.0f, (PxVec3(1.0f, 0.0f, 0.0f))));
-		((PxRigidBody*)ball[balls]->mesh->Get())->setLinearVelocity(PxVec3(0.0f, 0.0f, 0.0f));
-		((PxRigidBody*)ball[balls]->mesh->Get())->setAngularVelocity(PxVec3(0.0f, 0.0f, 0.0f));
-		((PxRigidBody*)ball[balls]->mesh->Get())->setGlobalPose(transform);
+		pose_batch.Pose(entities.body[ballFirst + loadedBall], transform);
+		pose_batch.Velocity(entities.body[ballFirst + loadedBall], PxVec3(0.0f, 0.0f, 0.0f), PxVec3(0.0f, 0.0f, 0.0f));
 	}
 
 	// Destroy a castle
-	void GameScene::DestroyCastle(vector<Box*>& castle)
+	void GameScene::DestroyCastle(int castle)
 	{
-		for (int i = 0; i < castle.size(); i++)
+		// Blow the bricks still in the stadium apart
+		Burst(ENTITY_BRICK, (PxU16)castle, PxVec3(-375.0f, 250.0f, -375.0f), PxVec3(375.0f, 250.0f, 375.0f));
+		castlesDestroyed++;
+
+		// Credit the team whose ball knocked the target over
+		for (PxU32 i = 0; i < entities.Size(); i++)
 		{
-			int min = -15;
-			int max = 15;
-			float randomForce = (float)rand() / (float)RAND_MAX;
-			((PxRigidBody*)castle[i]->Get())->addForce(PxVec3(min + randomForce * (max - min), 10.0f, min + randomForce * (max - min)) * 25.0f, PxForceMode::eIMPULSE);
+			if (entities.kind[i] == ENTITY_BRICK && entities.group[i] == castle)
+			{
+				teamCastlesDestroyed[entities.team[i]]++;
+				break;
+			}
 		}
-		castlesDestroyed++;
-		castleDestroyed = true;
-		bridgeTimer = 0.5f;
+
+		// Open the bridge a little - another castle keeps it going for longer
+		drawBridgeJoint->DriveVelocity(1.0f);
+		timers.Cancel(bridgeStop);
+		bridgeStop = timers.Schedule(0.5f, [this]() { drawBridgeJoint->DriveVelocity(0.0f); });
+	}
+
+	// Queue a random impulse for every entity of a kind (and group, 0 for any) still in the scene
+	void GameScene::Burst(EntityKind kind, PxU16 group, const PxVec3& min, const PxVec3& max)
+	{
+		effectBodies.clear();
+		for (PxU32 i = 0; i < entities.Size(); i++)
+		{
+			if (entities.kind[i] == kind && (!group || entities.group[i] == group) && (entities.flags[i] & ENTITY_IN_SCENE))
+				effectBodies.push_back(entities.body[i]);
+		}
+
+		// The generator writes straight into the batch
+		PxU32 count = (PxU32)effectBodies.size();
+		if (count) random.Vectors(impulse_batch.Add(effectBodies.data(), count), count, min, max);
 	}
 
 	// Set spinners
@@ -796,8 +932,10 @@ namespace PhysicsEngine
 		Add(spinnerBox);
 
 		spinnerBase = new Box(PxTransform(PxVec3(xOffset, 5.0f, zOffset)), PxVec3(0.5f, 5.0f, 0.25f));
+		spinnerBase->Bake();
 		Add(spinnerBase);
-		spinnerBase->SetKinematic(true);
+		shotProps.push_back(spinnerBox);
+		shotProps.push_back(spinnerBase);
 
 		spinner = new RevoluteJoint(spinnerBase, PxTransform(PxVec3(0.0f, height, 0.0f), PxQuat(PxPi / 2.0f, PxVec3(0.0f, 0.0f, 1.0f))), spinnerBox, PxTransform(PxVec3(0.0f, 5.0f, 0.0f)));
 		spinner->DriveVelocity(drive);
@@ -813,13 +951,22 @@ namespace PhysicsEngine
 		trampoline2 = new Trampoline(1000.0f, 10.0f, PxVec3(5.0f, 5.0f, 5.0f), PxTransform(PxVec3(xOffset, 1.0f, zOffset), PxQuat(PxPiDivTwo, PxVec3(0.0f, 1.0f, 0.0f))), PxTransform(PxVec3(xOffset, 5.0f, zOffset), PxQuat(PxPiDivTwo, PxVec3(0.0f, 1.0f, 0.0f))));
 		trampoline2->AddToScene(this);
 
-		bouncer1 = new Player(true, PxTransform(PxVec3(-xOffset, 50.0f, zOffset)), PxVec3(0.5f, 0.5f, 0.5f));
+		vector<Actor*> parts = trampoline1->Parts();
+		shotProps.insert(shotProps.end(), parts.begin(), parts.end());
+		parts = trampoline2->Parts();
+		shotProps.insert(shotProps.end(), parts.begin(), parts.end());
+
+		// Bouncers, dropped from where they start
+		bouncerHomes[0] = PxTransform(PxVec3(-xOffset, 50.0f, zOffset));
+		bouncerHomes[1] = PxTransform(PxVec3(xOffset, 50.0f, zOffset));
+
+		bouncer1 = new Player(true, bouncerHomes[0], PxVec3(0.5f, 0.5f, 0.5f));
 		((PxRigidBody*)bouncer1->Get())->setMass(150.0f);
 		bouncer1->Material(CreateMaterial(0.75f, 0.75f, 0.0f));
 		bouncer1->Color(color_palette[0]);
 		Add(bouncer1);
 
-		bouncer2 = new Player(true, PxTransform(PxVec3(xOffset, 50.0f, zOffset)), PxVec3(0.5f, 0.5f, 0.5f));
+		bouncer2 = new Player(true, bouncerHomes[1], PxVec3(0.5f, 0.5f, 0.5f));
 		((PxRigidBody*)bouncer2->Get())->setMass(150.0f);
 		bouncer2->Material(CreateMaterial(0.75f, 0.75f, 0.0f));
 		bouncer2->Color(color_palette[0]);
@@ -829,85 +976,533 @@ namespace PhysicsEngine
 	// Set the fireworks
 	void GameScene::SetFireWorks(int count, float xOffset, float zOffset)
 	{
-		for (int i = 1; i <= count; i++)
+		// Left (1) and right (2) stacks
+		for (int side = 1; side <= 2; side++)
 		{
-			fireworks1.push_back(new Box(PxTransform(PxVec3(-xOffset, 1.0f * i, zOffset)), PxVec3(0.5f, 0.5f, 0.5f)));
-			Add(fireworks1.back());
-			fireworks1.back()->Color(color_palette[1]);
-			fireworks2.push_back(new Box(PxTransform(PxVec3(xOffset, 1.0f * i, zOffset)), PxVec3(0.5f, 0.5f, 0.5f)));
-			Add(fireworks2.back());
-			fireworks2.back()->Color(color_palette[1]);
+			// One broadphase entry per stack
+			Aggregate* group = useAggregates ? new Aggregate(count, fireworkSelfCollision) : 0;
+			float x = side == 1 ? -xOffset : xOffset;
 
-			switch (i % 3)
+			vector<Box*> stack;
+			for (int i = 1; i <= count; i++)
 			{
-			case 0:
-				fireworks1.back()->Color(color_palette[0]);
-				fireworks2.back()->Color(color_palette[0]);
-				break;
-			case 1:
-				fireworks1.back()->Color(color_palette[1]);
-				fireworks2.back()->Color(color_palette[1]);
-				break;
-			case 2:
-				fireworks1.back()->Color(color_palette[2]);
-				fireworks2.back()->Color(color_palette[2]);
-				break;
-			default:
-				fireworks1.back()->Color(color_palette[2] / 2.0f);
-				fireworks2.back()->Color(color_palette[2] / 2.0f);
-				break;
+				Box* firework = new Box(PxTransform(PxVec3(x, 1.0f * i, zOffset)), PxVec3(0.5f, 0.5f, 0.5f));
+				firework->Color(color_palette[i % 3]);
+				stack.push_back(firework);
+				entities.Add(firework, ENTITY_FIREWORK, TEAM_NONE, (PxU16)side);
 			}
+			AddRange(stack, group);
+
+			if (group) Add(group);
 		}
 	}
 
 	// Fire works
 	void GameScene::FireWorks()
 	{
-		for (int i = 0; i < fireworks1.size(); i++)
-		{
-			int min = -15;
-			int max = 15;
-			float randomForce = (float)rand() / (float)RAND_MAX;
-			((PxRigidBody*)fireworks1[i]->Get())->addForce(PxVec3(min + randomForce * (max - min), 10.0f, min + randomForce * (max - min)), PxForceMode::eIMPULSE);
-			((PxRigidBody*)fireworks2[i]->Get())->addForce(PxVec3(min + randomForce * (max - min), 10.0f, min + randomForce * (max - min)), PxForceMode::eIMPULSE);
-		}
+		Burst(ENTITY_FIREWORK, 0, PxVec3(-15.0f, 10.0f, -15.0f), PxVec3(15.0f, 10.0f, 15.0f));
 
-		fireworkTimer = 7.5f;
+		// Stack them up again once they have landed
+		timers.Cancel(fireworkReset);
+		fireworkReset = timers.Schedule(7.5f, [this]() { ResetFireWorks(); });
 	}
 
 	// Set the cannons
 	void GameScene::SetCannons(float xOffset, float zOffset)
 	{
 		cannon1 = new Cannon(PxTransform(PxVec3(-xOffset, 19.0f, zOffset ), PxQuat(PxPi / 4.0f, (PxVec3(0.0f, 1.0f, 0.0f)))), PxVec3(1.5f, 1.5f, 1.5f));
-		cannon1->SetKinematic(true);
 		cannon1->Color(color_palette[5] / 2.0f);
-		Add(cannon1);
+		cannon1->MergeInto(stadium);
 
 		cannon2 = new Cannon(PxTransform(PxVec3(xOffset, 21.0f, zOffset), PxQuat(-PxPi / 4.0f, (PxVec3(0.0f, 1.0f, 0.0f)))), PxVec3(1.5f, 1.5f, 1.5f));
-		cannon2->SetKinematic(true);
 		cannon2->Color(color_palette[5] / 2.0f);
-		Add(cannon2);
-
-		bullet1 = new Sphere(PxTransform(PxVec3(-xOffset, 19.0f, zOffset )), 1.0f);
-		bullet1->Color(color_palette[5]);
-		((PxRigidBody*)bullet1->Get())->setMass(50.0f);
-		bullet1->SetKinematic(true);
-		Add(bullet1);
+		cannon2->MergeInto(stadium);
 
-		bullet2 = new Sphere(PxTransform(PxVec3(xOffset, 21.0f, zOffset)), 1.0f);
-		bullet2->Color(color_palette[5]);
-		((PxRigidBody*)bullet2->Get())->setMass(50.0f);
-		bullet2->SetKinematic(true);
-		Add(bullet2);
+		// Left (1) and right (2) cannon balls
+		for (int side = 1; side <= 2; side++)
+		{
+			Sphere* bullet = new Sphere(PxTransform(side == 1 ? PxVec3(-xOffset, 19.0f, zOffset) : PxVec3(xOffset, 21.0f, zOffset)), 1.0f);
+			bullet->Color(color_palette[5]);
+			((PxRigidBody*)bullet->Get())->setMass(50.0f);
+			bullet->SetKinematic(true);
+			Add(bullet);
+			entities.Add(bullet, ENTITY_BULLET, TEAM_NONE, (PxU16)side);
+		}
 	}
 
 	// Set the cannons
 	void GameScene::FireCannons()
 	{
-		fireTimer = 5.0f;
-		bullet1->SetKinematic(false);
-		bullet2->SetKinematic(false);
-		((PxRigidBody*)bullet1->Get())->addForce(PxVec3(2000.0f, 0.0f, 2000.0f), PxForceMode::eIMPULSE);
-		((PxRigidBody*)bullet2->Get())->addForce(PxVec3(-2000.0f, 0.0f, 2000.0f), PxForceMode::eIMPULSE);
+		// Reload in 5 seconds
+		timers.Cancel(cannonReload);
+		cannonReload = timers.Schedule(5.0f, [this]() { ReloadCannons(); });
+
+		for (PxU32 i = 0; i < entities.Size(); i++)
+		{
+			if (entities.kind[i] != ENTITY_BULLET) continue;
+
+			entities.body[i]->setRigidDynamicFlag(PxRigidDynamicFlag::eKINEMATIC, false);
+			impulse_batch.Add(entities.body[i], PxVec3(entities.group[i] == 1 ? 2000.0f : -2000.0f, 0.0f, 2000.0f));
+		}
+	}
+
+	// Fill the entity table with loose bricks, asleep in rows behind the kicker
+	void GameScene::SpawnDebris(PxU32 total)
+	{
+		PxU32 first = entities.Size();
+		for (PxU32 i = first; i < total; i++)
+		{
+			PxU32 n = i - first;
+			Box* box = new Box(PxTransform(PxVec3(-60.0f + 2.0f * (n % 61), 0.5f, 60.0f + 2.0f * (n / 61))), PxVec3(0.5f, 0.5f, 0.5f));
+			box->Color(color_palette[5]);
+			Add(box);
+			regions.Track(entities.Add(box, ENTITY_BRICK), REGION_DESPAWN);
+			((PxRigidDynamic*)box->Get())->putToSleep();
+		}
+	}
+
+	// Track the moving props in the region manager
+	void GameScene::SetRegions()
+	{
+		// Pitch (grass and goal areas) and stadium (walls, fireworks and cannons)
+		regions.Clear();
+		regions.Bounds(PxBounds3(PxVec3(-70.0f, -5.0f, -100.0f), PxVec3(70.0f, 60.0f, 100.0f)), PxBounds3(PxVec3(-75.0f, -5.0f, -115.0f), PxVec3(75.0f, 100.0f, 105.0f)));
+
+		// The firework stacks stand 10m behind the pitch - sleep well clear of them, on top of the 1m pitch boxes
+		regions.SleepDistance(15.0f);
+		regions.Ground(1.0f, 3.0f);
+
+		// Balls go back to the pool, castle bricks are debris, fireworks and bullets are reset by their timers
+		for (PxU32 i = 0; i < entities.Size(); i++)
+		{
+			switch (entities.kind[i])
+			{
+			case ENTITY_BALL:	regions.Track(i, REGION_PARK); break;
+			case ENTITY_BRICK:	regions.Track(i, REGION_DESPAWN); break;
+			default:			regions.Track(i, REGION_SLEEP); break;
+			}
+		}
+	}
+
+	// Start the trajectory preview
+	void GameScene::SetTrajectory()
+	{
+		trajectoryPower = -1;
+		if (showTrajectory)
+			trajectory.Init((PxRigidActor*)stadium->Get(), plane ? (PxRigidActor*)plane->Get() : nullptr, (PxRigidDynamic*)ball[0]->mesh->Get(), CustomFilterShader);
+	}
+
+	// Ask for a new prediction if the power or kicker pose changed
+	void GameScene::UpdateTrajectory()
+	{
+		if (!trajectory.Running() || kicked || loadedBall == -1) return;
+
+		PxTransform base = ((PxRigidBody*)kickerBase->Get())->getGlobalPose();
+		if (power == trajectoryPower && (base.p - trajectoryPose.p).magnitudeSquared() < 1e-4f && PxAbs(base.q.dot(trajectoryPose.q)) > 0.99999f)
+			return;
+
+		trajectoryPower = power;
+		trajectoryPose = base;
+
+		// Same start as SetBallPose, leaving along the kicker's forward axis
+		PxTransform start(base.p, PxQuat(PxPi / 2.0f, PxVec3(1.0f, 0.0f, 0.0f)));
+		PxVec3 direction = base.q.rotate(PxVec3(0.0f, PxSin(kickLaunchAngle), -PxCos(kickLaunchAngle)));
+		trajectory.Request(start, direction * (power / 10.0f) * kickArmLength);
+	}
+
+	// Kick from a grid of positions and powers in headless copies of the pitch
+	void GameScene::EvaluateShots()
+	{
+		if (shotEvaluator) return;
+		shotEvaluator = new ShotEvaluator(0, CustomFilterShader);
+
+		// Stadium and castle targets are static (a target falls for the balls in its filter mask), castle bricks are put back before every kick
+		shotEvaluator->Static((PxRigidActor*)stadium->Get());
+		for (int i = 0; i < castleTargets.size(); i++)
+		{
+			shotEvaluator->Static((PxRigidActor*)castleTargets[i]->Get());
+			shotEvaluator->Target(((PxRigidActor*)castleTargets[i]->Get())->getWorldBounds(), castleTargets[i]->GetShape()->getSimulationFilterData().word1);
+		}
+
+		// The draw bridge, spinners and trampolines are frozen where they are now
+		for (PxU32 i = 0; i < shotProps.size(); i++)
+			shotEvaluator->Static((PxRigidActor*)shotProps[i]->Get());
+
+		for (PxU32 i = 0; i < entities.Size(); i++)
+			if (entities.kind[i] == ENTITY_BRICK && entities.body[i]->getScene())
+				shotEvaluator->Obstacle(entities.body[i]);
+
+		// A blue and a red ball, kicked in turn
+		for (int i = 0; i < 2 && i < ball.size(); i++)
+			shotEvaluator->Projectile((PxRigidDynamic*)ball[i]->mesh->Get());
+		shotEvaluator->Goal(((PxRigidActor*)goalCollisionShape->Get())->getWorldBounds());
+		shotEvaluator->Kick(kickArmLength, kickLaunchAngle);
+
+		// Kicker positions on our half of the pitch, every power step
+		for (float x = -40.0f; x <= 40.0f; x += 10.0f)
+			for (float z = 0.0f; z <= 40.0f; z += 10.0f)
+				for (int p = 30; p <= maxPower; p += 5)
+					shotEvaluator->Cell(PxVec3(x, 3.5f, z), p);
+
+		shotEvaluator->Start(shotKicksPerCell);
+	}
+
+	// Fraction of the shot map done
+	float GameScene::ShotProgress()
+	{
+		return shotEvaluator ? shotEvaluator->Progress() : -1.0f;
+	}
+
+	// Shot map progress, or how the last one ended
+	string GameScene::ShotStatus()
+	{
+		return shotEvaluator ? to_string((int)(ShotProgress() * 100.0f)) + "%" : shotStatus;
+	}
+
+	// Schedule the timed events of a fresh scene
+	void GameScene::SetTimers()
+	{
+		timers.Clear();
+		bridgeStop = fireworkReset = cannonReload = TimerId();
+
+		// Load the first ball - a rebuilt scene starts with an empty kicker, kicked or not
+		kicked = false;
+		kickReady = balls > 0;
+		if (balls > 0) NewBall();
+		else timers.Schedule(0.0f, [this]() { ReloadKicker(); });
+
+		// Drop the bouncers every 15 seconds
+		timers.Schedule(0.0f, [this]() { DropBouncers(); }, 15.0f);
+	}
+
+	// Swing the kicker arm back
+	void GameScene::ReturnKicker()
+	{
+		power = 30;
+		kickJoint->DriveVelocity(-1.0f);
+	}
+
+	// Load the next ball (waits for more balls when there are none)
+	void GameScene::ReloadKicker()
+	{
+		if (balls == 0)
+		{
+			timers.Schedule(0.5f, [this]() { ReloadKicker(); });
+			return;
+		}
+
+		kicked = false;
+		NewBall();
+
+		// Can kick again 4 seconds after the ball is loaded
+		timers.Schedule(4.0f, [this]() { kickReady = true; });
+	}
+
+	// Reset the fireworks - batched
+	void GameScene::ResetFireWorks()
+	{
+		for (PxU32 i = 0; i < entities.Size(); i++)
+		{
+			if (entities.kind[i] != ENTITY_FIREWORK) continue;
+
+			pose_batch.Pose(entities.body[i], entities.home[i]);
+			pose_batch.Velocity(entities.body[i], PxVec3(0.0f, 0.0f, 0.0f), PxVec3(0.0f, 0.0f, 0.0f));
+		}
+	}
+
+	// Drop the bouncers from the top
+	void GameScene::DropBouncers()
+	{
+		pose_batch.Pose((PxRigidDynamic*)bouncer1->Get(), bouncerHomes[0]);
+		pose_batch.Pose((PxRigidDynamic*)bouncer2->Get(), bouncerHomes[1]);
+	}
+
+	// Put the cannon balls back in the cannons
+	void GameScene::ReloadCannons()
+	{
+		for (PxU32 i = 0; i < entities.Size(); i++)
+		{
+			if (entities.kind[i] != ENTITY_BULLET) continue;
+
+			pose_batch.Pose(entities.body[i], entities.home[i]);
+			entities.body[i]->setRigidDynamicFlag(PxRigidDynamicFlag::eKINEMATIC, true);
+		}
+	}
+
+	// The built-in layout
+	void GameScene::DefaultLevel(LevelWriter& level)
+	{
+		// Materials (plain is the PhysX default the unmaterialled props used)
+		PxU32 plain = level.AddMaterial(0.0f, 0.0f, 0.0f);
+		PxU32 longGrass = level.AddMaterial(0.75f, 0.75f, 0.25f);
+		PxU32 shortGrass = level.AddMaterial(0.55f, 0.55f, 0.45f);
+		PxU32 concrete = level.AddMaterial(0.80f, 1.00f, 0.14f);
+
+		// Ground plane
+		level.AddActor(LEVEL_STATIC, PxTransformFromPlaneEquation(PxPlane(PxVec3(0.0f, 1.0f, 0.0f), 0.0f)), PxVec3(0.0f, 0.0f, 1.0f), "Plane");
+		level.AddShape(LEVEL_PLANE, PxVec3(0.0f), plain);
+
+		// Pitch grass - long and short stripes, and the goal areas
+		const PxVec3 half(34.875f, 1.0f, 29.75f);
+		level.AddActor(LEVEL_STADIUM, PxTransform(PxVec3(-34.875f, 0.0f, 30.0f)), color_palette[1] / 2.0f, "PitchBottomLeft");
+		level.AddShape(LEVEL_BOX, half, longGrass);
+		level.AddActor(LEVEL_STADIUM, PxTransform(PxVec3(34.875f, 0.0f, 30.0f)), color_palette[1], "PitchBottomRight");
+		level.AddShape(LEVEL_BOX, half, shortGrass);
+		level.AddActor(LEVEL_STADIUM, PxTransform(PxVec3(34.875f, 0.0f, -30.0f)), color_palette[1] / 2.0f, "PitchTopLeft");
+		level.AddShape(LEVEL_BOX, half, longGrass);
+		level.AddActor(LEVEL_STADIUM, PxTransform(PxVec3(-34.875f, 0.0f, -30.0f)), color_palette[1], "PitchTopRight");
+		level.AddShape(LEVEL_BOX, half, shortGrass);
+		level.AddActor(LEVEL_STADIUM, PxTransform(PxVec3(0.0f, 0.0f, -90.0f)), color_palette[1], "PitchTopGoal");
+		level.AddShape(LEVEL_BOX, PxVec3(69.75f, 1.0f, 9.75f), plain);
+		level.AddActor(LEVEL_STADIUM, PxTransform(PxVec3(0.0f, 0.0f, 90.0f)), color_palette[1], "PitchBottomGoal");
+		level.AddShape(LEVEL_BOX, PxVec3(69.75f, 1.0f, 9.75f), plain);
+
+		// Pitch lines - touch lines, dead ball lines, 20m lines and halfway
+		level.AddActor(LEVEL_STADIUM, PxTransform(PxIdentity), color_palette[3], "PitchLines");
+		level.AddShape(LEVEL_BOX, PxVec3(0.25f, 1.0f, 100.0f), plain, PxTransform(PxVec3(70.0f, 0.0f, 0.0f)));
+		level.AddShape(LEVEL_BOX, PxVec3(0.25f, 1.0f, 100.0f), plain, PxTransform(PxVec3(-70.0f, 0.0f, 0.0f)));
+		const PxReal line_z[] = { 100.0f, -100.0f, 80.0f, -80.0f, 0.0f };
+		for (PxU32 i = 0; i < 5; i++)
+			level.AddShape(LEVEL_BOX, PxVec3(70.0f, 1.0f, 0.25f), plain, PxTransform(PxVec3(0.0f, 0.0f, line_z[i])));
+
+		// Posts at both ends - crossbar and two uprights
+		level.AddActor(LEVEL_STADIUM, PxTransform(PxIdentity), PxVec3(1.0f, 1.0f, 1.0f), "Posts");
+		for (int end = -1; end <= 1; end += 2)
+		{
+			level.AddShape(LEVEL_BOX, PxVec3(5.5f, 0.25f, 0.25f), plain, PxTransform(PxVec3(0.0f, 10.0f, 85.0f * end)));
+			level.AddShape(LEVEL_BOX, PxVec3(0.25f, 12.5f, 0.25f), plain, PxTransform(PxVec3(5.5f, 12.5f, 85.0f * end)));
+			level.AddShape(LEVEL_BOX, PxVec3(0.25f, 12.5f, 0.25f), plain, PxTransform(PxVec3(-5.5f, 12.5f, 85.0f * end)));
+		}
+
+		// Goal trigger between the posts
+		level.AddActor(LEVEL_STATIC, PxTransform(PxVec3(0.0f, 40.25f, -85.5f)), PxVec3(1.0f, 1.0f, 1.0f), "GoalTrigger_inv", 1.0f, LEVEL_TRIGGER | LEVEL_HIDDEN);
+		level.AddShape(LEVEL_BOX, PxVec3(5.0f, 30.0f, 0.1f), plain);
+
+		// Castle wall across the pitch (w = half extents of the gate wall), its towers, battlements and side walls
+		const PxVec3 w(70.0f, 10.0f, 2.5f);
+		level.AddActor(LEVEL_STADIUM, PxTransform(PxVec3(0.0f, 10.0f, -80.0f)), color_palette[5], "Wall");
+		level.AddShape(LEVEL_BOX, PxVec3(w.x / 2.5f, w.y, w.z), concrete, PxTransform(PxVec3(-w.x + (w.x / 2.5f), 0.0f, 0.0f)));
+		level.AddShape(LEVEL_BOX, PxVec3(w.x / 2.5f, w.y, w.z), concrete, PxTransform(PxVec3(w.x - (w.x / 2.5f), 0.0f, 0.0f)));
+		level.AddShape(LEVEL_BOX, PxVec3(w.x / 10.0f, w.y * 1.25f, w.z * 2.5f), concrete, PxTransform(PxVec3(-w.x, w.y - (w.y / 1.25f), 0.0f)));
+		level.AddShape(LEVEL_BOX, PxVec3(w.x / 10.0f, w.y * 1.25f, w.z * 2.5f), concrete, PxTransform(PxVec3(w.x, w.y - (w.y / 1.25f), 0.0f)));
+		for (int side = -1; side <= 1; side += 2)
+		{
+			for (int i = 0; i < 5; i++)
+				level.AddShape(LEVEL_BOX, PxVec3(w.x / 30.0f, w.y / 5.0f, w.z), concrete, PxTransform(PxVec3(side * ((w.x / 30.0f + (w.x / 5.0f)) + (i * (w.x / 7.0f))), w.y, 0.0f)));
+		}
+		for (int side = -1; side <= 1; side += 2)
+		{
+			level.AddShape(LEVEL_BOX, PxVec3(w.x / 30.0f, w.y, w.z * 36.0f), concrete, PxTransform(PxVec3(side * w.x, 0.0f, w.z * 36.0f)));
+			for (int i = 0; i < 15; i++)
+				level.AddShape(LEVEL_BOX, PxVec3(w.x / 30.0f, w.y / 5.0f, w.z), concrete, PxTransform(PxVec3(side * w.x, w.y, ((w.z * 72.0f) - w.z) - (i * (w.z * 5.0f)))));
+		}
+
+		// Flag poles on the wall towers
+		for (int side = -1; side <= 1; side += 2)
+		{
+			level.AddActor(LEVEL_STADIUM, PxTransform(PxVec3(70.0f * side, 35.0f, -80.0f)), color_palette[3], "FlagPole");
+			level.AddShape(LEVEL_BOX, PxVec3(0.25f, 10.0f, 0.25f), plain);
+		}
+
+		// Castles (x, z, target offset, colour)
+		level.AddPrefab(LEVEL_CASTLE, PxVec3(-25.0f, 0.0f, -40.0f), 3.0f, 0.0f);
+		level.AddPrefab(LEVEL_CASTLE, PxVec3(-35.0f, 0.0f, -20.0f), 3.0f, 2.0f);
+		level.AddPrefab(LEVEL_CASTLE, PxVec3(20.0f, 0.0f, -40.0f), 3.0f, 0.0f);
+		level.AddPrefab(LEVEL_CASTLE, PxVec3(30.0f, 0.0f, -20.0f), 3.0f, 2.0f);
+
+		// Goal castle (draw bridge and flags, placed against the wall above), teams and kicker
+		level.AddPrefab(LEVEL_GOAL_CASTLE, PxVec3(0.0f, 0.0f, 0.0f));
+		level.AddPrefab(LEVEL_TEAMS, PxVec3(0.0f, 0.0f, 5.0f));
+		level.AddPrefab(LEVEL_KICKER, PxVec3(0.0f, 0.0f, 20.0f));
+
+		// Trampolines
+		level.AddPrefab(LEVEL_TRAMPOLINES, PxVec3(55.0f, 0.0f, -20.0f));
+
+		// Spinners (x, z, height, drive)
+		level.AddPrefab(LEVEL_SPINNER, PxVec3(-5.0f, 0.0f, -20.0f), 4.0f, -0.25f);
+		level.AddPrefab(LEVEL_SPINNER, PxVec3(5.0f, 0.0f, -45.0f), 12.0f, 0.5f);
+
+		// Fireworks and cannons
+		level.AddPrefab(LEVEL_FIREWORKS, PxVec3(20.0f, 0.0f, -110.0f), 20.0f);
+		level.AddPrefab(LEVEL_CANNONS, PxVec3(52.0f, 0.0f, -76.0f));
+	}
+
+	// A level has to place the rigs the game drives exactly once
+	bool GameScene::CheckLevel(const LevelFile& level)
+	{
+		PxU32 count;
+		const LevelPrefab* prefabs = level.Prefabs(count);
+
+		PxU32 placed[LEVEL_PREFAB_TYPES] = { 0 };
+		for (PxU32 i = 0; i < count; i++)
+			placed[prefabs[i].type]++;
+
+		bool valid = placed[LEVEL_KICKER] == 1 && placed[LEVEL_GOAL_CASTLE] == 1 && placed[LEVEL_TRAMPOLINES] == 1
+			&& placed[LEVEL_FIREWORKS] == 1 && placed[LEVEL_CANNONS] == 1 && placed[LEVEL_TEAMS] <= 1 && placed[LEVEL_CASTLE] <= 4;
+
+		// And the goal trigger the shot map aims at
+		PxU32 actor_count;
+		const LevelActor* actors = level.Actors(actor_count);
+		PxU32 goals = 0;
+		for (PxU32 i = 0; i < actor_count; i++)
+		{
+			if (actors[i].type != LEVEL_STADIUM && string(actors[i].name) == "GoalTrigger_inv")
+				goals++;
+		}
+
+		return valid && goals == 1;
+	}
+
+	// Build a level in one pass over its records
+	void GameScene::BuildLevel(const LevelFile& level)
+	{
+		// Materials
+		PxU32 material_count;
+		const LevelMaterial* materials = level.Materials(material_count);
+		vector<PxMaterial*> level_materials(material_count);
+		for (PxU32 i = 0; i < material_count; i++)
+			level_materials[i] = CreateMaterial(materials[i].static_friction, materials[i].dynamic_friction, materials[i].restitution);
+
+		// Actors and their shapes
+		PxU32 actor_count, shape_count;
+		const LevelActor* actors = level.Actors(actor_count);
+		const LevelShape* shapes = level.Shapes(shape_count);
+		vector<Actor*> level_actors(actor_count);
+		plane = nullptr;
+		goalCollisionShape = nullptr;
+		for (PxU32 i = 0; i < actor_count; i++)
+		{
+			const LevelActor& record = actors[i];
+			Actor* actor;
+			if (record.type == LEVEL_STATIC) actor = new StaticActor(record.pose);
+			else actor = new DynamicActor(record.pose);
+
+			for (PxU32 j = 0; j < record.shape_count; j++)
+			{
+				const LevelShape& shape = shapes[record.first_shape + j];
+				switch (shape.type)
+				{
+				case LEVEL_SPHERE: actor->CreateShape(PxSphereGeometry(shape.size.x), record.density); break;
+				case LEVEL_CAPSULE: actor->CreateShape(PxCapsuleGeometry(shape.size.x, shape.size.y), record.density); break;
+				case LEVEL_BOX: actor->CreateShape(PxBoxGeometry(shape.size), record.density); break;
+				case LEVEL_PLANE: actor->CreateShape(PxPlaneGeometry(), record.density); break;
+				}
+				actor->GetShape(j)->setLocalPose(shape.local_pose);
+				if (material_count) actor->Material(level_materials[shape.material], j);
+			}
+
+			actor->Color(record.color);
+			actor->Name(record.name);
+			if (record.flags & LEVEL_TRIGGER) actor->SetTrigger(true);
+			if (record.flags & LEVEL_HIDDEN) actor->Visible(false);
+
+			// Stadium props are merged (joints then attach to the stadium), the rest added on their own
+			if (record.type == LEVEL_STADIUM)
+			{
+				actor->MergeInto(stadium);
+				delete actor;
+				actor = stadium;
+			}
+			else
+			{
+				if (record.type == LEVEL_KINEMATIC) ((DynamicActor*)actor)->SetKinematic(true);
+				Add(actor);
+
+				// Actors the game looks up by name
+				if (string(record.name) == "Plane") plane = actor;
+				else if (string(record.name) == "GoalTrigger_inv") goalCollisionShape = actor;
+			}
+			level_actors[i] = actor;
+		}
+
+		// Joints (frames of stadium props are relative to the stadium)
+		PxU32 joint_count;
+		const LevelJoint* joints = level.Joints(joint_count);
+		for (PxU32 i = 0; i < joint_count; i++)
+		{
+			const LevelJoint& record = joints[i];
+			Actor* actor0 = record.actor0 == 0xffffffff ? nullptr : level_actors[record.actor0];
+			Actor* actor1 = record.actor1 == 0xffffffff ? nullptr : level_actors[record.actor1];
+
+			if (record.type == LEVEL_DISTANCE)
+			{
+				DistanceJoint* joint = new DistanceJoint(actor0, record.frame0, actor1, record.frame1);
+				joint->Stiffness(record.stiffness);
+				joint->Damping(record.damping);
+				levelJoints.push_back(joint);
+			}
+			else
+			{
+				RevoluteJoint* joint = new RevoluteJoint(actor0, record.frame0, actor1, record.frame1);
+				if (record.drive != 0.0f) joint->DriveVelocity(record.drive);
+				if (record.flags & LEVEL_LIMITED) joint->SetLimits(record.lower, record.upper);
+				levelJoints.push_back(joint);
+			}
+		}
+
+		// Game rigs
+		PxU32 prefab_count;
+		const LevelPrefab* prefabs = level.Prefabs(prefab_count);
+		int castle = 1;
+		for (PxU32 i = 0; i < prefab_count; i++)
+		{
+			const LevelPrefab& prefab = prefabs[i];
+			PxVec3 p = prefab.position;
+			switch (prefab.type)
+			{
+			case LEVEL_CASTLE:
+			{
+				BuildCastle(p.x, p.z, prefab.params[0], color_palette[(int)prefab.params[1]], castle++);
+				break;
+			}
+			case LEVEL_GOAL_CASTLE:	BuildGoalCastle(p.x, p.z); break;
+			case LEVEL_TEAMS:		BuildTeams(p.z); break;
+			case LEVEL_KICKER:		BuildKickers(p.x, p.z); break;
+			case LEVEL_TRAMPOLINES:	SetTrampolines(p.x, p.z); break;
+			case LEVEL_SPINNER:		SetSpinners(p.x, p.z, prefab.params[0], prefab.params[1]); break;
+			case LEVEL_FIREWORKS:	SetFireWorks((int)prefab.params[0], p.x, p.z); break;
+			case LEVEL_CANNONS:		SetCannons(p.x, p.z); break;
+			}
+		}
+	}
+
+	// Write the built-in layout
+	void GameScene::SaveDefaultLevel(const string& path)
+	{
+		LevelWriter defaults;
+		DefaultLevel(defaults);
+		if (defaults.Save(path))
+			levelStatus = "built-in written to " + path;
+		else
+			levelStatus = "could not write " + path;
+	}
+
+	// Release the joints of the last level and forget its castles (the scene reset has already removed the actors)
+	void GameScene::ReleaseLevel()
+	{
+		for (PxU32 i = 0; i < levelJoints.size(); i++)
+		{
+			levelJoints[i]->Get()->release();
+			delete levelJoints[i];
+		}
+		levelJoints.clear();
+
+		for (PxU32 i = 0; i < targetJoints.size(); i++)
+		{
+			targetJoints[i]->Get()->release();
+			delete targetJoints[i];
+		}
+		targetJoints.clear();
+
+		castleTargets.clear();
+		castleTriggers.clear();
+		castleIndex = 1;
+		shotProps.clear();
+	}
+
+	// Which level is loaded
+	string GameScene::LevelStatus()
+	{
+		return levelStatus;
 	}
 }
\ No newline at end of file
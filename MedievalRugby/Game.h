@@ -1,6 +1,14 @@
 #pragma once
 
 #include "Actors.h"
+#include "EntityTable.h"
+#include "RegionManager.h"
+#include "ClothLOD.h"
+#include "TrajectoryPreview.h"
+#include "ShotEvaluator.h"
+#include "TimerWheel.h"
+#include "Level.h"
+#include "Random.h"
 #include <iostream>
 #include <iomanip>
 #include <stdlib.h> 
@@ -110,31 +118,17 @@ namespace PhysicsEngine
 	class GameScene : public Scene
 	{
 	public:
-		// Plane
-		Plane* plane;
+		// Ground plane (the level actor named "Plane", null if the level has none)
+		Actor* plane;
 
-		// Pitch
-		PitchLines* pitchLines;
-		Box* pitchTopLeft;
-		Box* pitchTopRight;
-		Box* pitchBottomLeft;
-		Box* pitchBottomRight;
-		Box* pitchTopGoal;
-		Box* pitchBottomGoal;
-
-		// Posts
-		Post* posts;
-
-		// Wall
-		Wall* wall;
+		// Never-moving props (the level's pitch, lines, posts, wall and flag poles, players, cannons) merged into one static actor
+		StaticActor* stadium;
 
 		// Ramps
 		Ramp* ramp1;
 		Ramp* ramp2;
 
 		// Materials
-		PxMaterial* longGrassMaterial;
-		PxMaterial* shortGrassMaterial;
 		PxMaterial* woodMaterial;
 		PxMaterial* leatherMaterial;
 		PxMaterial* rubberMaterial;
@@ -168,34 +162,43 @@ namespace PhysicsEngine
 
 		// Flags
 		Cloth* flag;
-		Box* flagPole;
 
 		// Trampolines
 		Trampoline* trampoline1;
 		Trampoline* trampoline2;
 		Player* bouncer1;
 		Player* bouncer2;
+		PxTransform bouncerHomes[2];
 
-		// Goal collision triggerr
-		Box* goalCollisionShape;
+		// Goal collision trigger (the level actor named "GoalTrigger_inv")
+		Actor* goalCollisionShape;
 
 		// Simulation Event Callback
 		SimulationEventCallback* collisionCallback;
 
-		// Castles
-		vector<Box*> castle1;
-		vector<Box*> castle2;
-		vector<Box*> castle3;
-		vector<Box*> castle4;
+		// Castles (the bricks are ENTITY_BRICK entities grouped by castle number)
 		vector<Box*> castleTargets;
 		vector<Box*> castleTriggers;
 		vector<RevoluteJoint*> targetJoints;
 		int castleIndex = 1;
 		int castlesDestroyed = 0;
-		bool castleDestroyed = false;
+		int teamCastlesDestroyed[3] = { 0, 0, 0 };
+
+		// Ball pool states
+		enum BallState
+		{
+			BALL_PARKED,	// Out of the scene, ready to be recycled
+			BALL_RACKED,	// Waiting on the pitch
+			BALL_LOADED,	// On the kicker
+			BALL_SPENT		// Kicked, parked once asleep or after spentBallLifetime
+		};
 
-		// Balls
+		// Balls - fixed capacity pool sharing one cooked hull (state and spent time in the entity table)
 		vector<Ball*> ball;
+		PxU32 ballFirst = 0;
+		int ballPoolSize = 40;
+		int loadedBall = -1;
+		float spentBallLifetime = 10.0f;
 
 		// Players
 		vector<Player*> playersRed;
@@ -206,25 +209,50 @@ namespace PhysicsEngine
 		Box* spinnerBase;
 		RevoluteJoint* spinner;
 
-		// Fireworks
-		vector<Box*> fireworks1;
-		vector<Box*> fireworks2;
-
-		// Cannons
+		// Cannons (fireworks and bullets are entities grouped by side)
 		Cannon* cannon1;
 		Cannon* cannon2;
-		Sphere* bullet1;
-		Sphere* bullet2;
+
+		// Balls, bricks, fireworks and bullets
+		EntityTable entities;
+
+		// Effect randomness and the bodies of the last burst
+		Random random;
+		vector<PxRigidDynamic*> effectBodies;
+
+		// Out of bounds bodies
+		RegionManager regions;
+
+		// Flag cloth level of detail (the visual debugger sets the view)
+		ClothLOD flagLOD;
+
+		// Predicted flight of the loaded ball
+		TrajectoryPreview trajectory;
+		bool showTrajectory = true;
+		int trajectoryPower = -1;
+		PxTransform trajectoryPose;
+
+		// Monte-Carlo shot map (null while not running) and the moving props it freezes in place (draw bridge, spinners, trampolines)
+		ShotEvaluator* shotEvaluator = nullptr;
+		vector<Actor*> shotProps;
+		PxU32 shotKicksPerCell = 16;
+		string shotStatus = "idle ('K' to build)";
 
 		// Constructor
 		GameScene() : Scene(CustomFilterShader) {};
 
+		// Destructor - stops an unfinished shot map
+		~GameScene() { delete shotEvaluator; }
+
 		// A custom scene class
 		void SetVisualisation();
 
 		// Custom scene initialisation
 		virtual void CustomInit();
 
+		// Custom setup once the initial actors are in the scene
+		virtual void CustomPostInit();
+
 		// Custom update function
 		virtual void CustomUpdate(PxReal dt);
 
@@ -234,6 +262,27 @@ namespace PhysicsEngine
 		// Get the shot power
 		float Power();
 
+		// Predicted flight of the loaded ball (null while nothing is loaded)
+		const TrajectoryPath* Trajectory();
+
+		// Start the trajectory preview
+		void SetTrajectory();
+
+		// Ask for a new prediction if the power or kicker pose changed
+		void UpdateTrajectory();
+
+		// Kick from a grid of positions and powers in headless copies of the pitch
+		void EvaluateShots();
+
+		// Fraction of the shot map done (-1 while not running)
+		float ShotProgress();
+
+		// Shot map progress, or how the last one ended
+		string ShotStatus();
+
+		// Which level is loaded, and the last level file written
+		string LevelStatus();
+
 		// Get the ball count
 		int Balls();
 
@@ -243,6 +292,18 @@ namespace PhysicsEngine
 		// Get the castle destroyed count
 		int DestroyedCastles();
 
+		// Get the castles destroyed by a team
+		int DestroyedCastles(EntityTeam team);
+
+		// Get the out of bounds bodies asleep past the pitch this step
+		int OutOfBoundsAsleep();
+
+		// Get the out of bounds bodies parked or removed past the stadium so far
+		int OutOfBoundsRemoved();
+
+		// Track the moving props in the region manager
+		void SetRegions();
+
 		// Key release handling
 		void KeyReleaseHandler(int key);
 
@@ -253,20 +314,38 @@ namespace PhysicsEngine
 		void KeyHoldHandler(int key);
 
 		// Build a castle
-		void BuildCastle(float xOffset, float zOffset, float targetOffset, PxVec3 colour, vector<Box*>& castle);
+		void BuildCastle(float xOffset, float zOffset, float targetOffset, PxVec3 colour, int castle);
+
+		// Castle brick positions on the 3m grid
+		vector<PxVec3> CastleLayout();
+
+		// Castle brick rest poses, settled once
+		const vector<PxTransform>& CastleRestPoses();
 
 		// Build a castle
 		void BuildTeams(float zOffset);
 
-		// Build the pitch
-		void BuildPitch();
-
-		// Build the pitch
-		void BuildGoalCastle();
+		// Build the goal castle (draw bridge and flags)
+		void BuildGoalCastle(float xOffset, float zOffset);
 
 		// Build the kickers
 		void BuildKickers(float xOffset, float zOffset);
 
+		// Build the ball pool
+		void BuildBallPool(int size);
+
+		// Get a parked ball, or recycle the oldest spent one (-1 if none)
+		int AcquireBall();
+
+		// Put a pooled ball in the scene at the pose
+		void ActivateBall(int index, const PxTransform& pose, BallState state);
+
+		// Take a pooled ball out of the scene
+		void ParkBall(int index);
+
+		// Park spent balls
+		void UpdateBallPool(PxReal dt);
+
 		// Set the balls
 		void SetBalls(int balls);
 
@@ -276,8 +355,11 @@ namespace PhysicsEngine
 		// Set ball pose
 		void SetBallPose();
 
-		// Destroy a castle
-		void DestroyCastle(vector<Box*>& castle);
+		// Destroy a castle (1 to 4)
+		void DestroyCastle(int castle);
+
+		// Queue a random impulse for every entity of a kind (and group, 0 for any) in the scene
+		void Burst(EntityKind kind, PxU16 group, const PxVec3& min, const PxVec3& max);
 
 		// Set spinners
 		void SetSpinners(float xOffset, float zOffset, float height, float drive);
@@ -297,6 +379,46 @@ namespace PhysicsEngine
 		// Set the cannons
 		void FireCannons();
 
+		// Fill the entity table up to a size with loose bricks (update cost benchmark)
+		void SpawnDebris(PxU32 total);
+
+		// The built-in layout
+		void DefaultLevel(LevelWriter& level);
+
+		// Does a level place every rig the game needs?
+		bool CheckLevel(const LevelFile& level);
+
+		// Build a level in one pass
+		void BuildLevel(const LevelFile& level);
+
+		// Release the joints of the last level build and forget its castles (a reset scene is built again)
+		void ReleaseLevel();
+
+		// Write the built-in layout
+		void SaveDefaultLevel(const string& path);
+
+		// Schedule the timed events
+		void SetTimers();
+
+		// Swing the kicker arm back
+		void ReturnKicker();
+
+		// Load the next ball
+		void ReloadKicker();
+
+		// Reset the fireworks
+		void ResetFireWorks();
+
+		// Drop the bouncers
+		void DropBouncers();
+
+		// Reload the cannons
+		void ReloadCannons();
+
+		// Kick model for the trajectory preview - the arm is not in the shadow scene, so the ball leaves at the arm tip speed
+		float kickArmLength	 = 6.0f;
+		float kickLaunchAngle = PxPi / 4.0f;
+
 		// Max kick power
 		int maxPower		 = 75;
 		bool kicked			 = true;
@@ -305,18 +427,26 @@ namespace PhysicsEngine
 		// Flags
 		bool followPlayer = true;
 
-		// Timers
-		float bridgeTimer			= 0.0f;
-		float initialBridgeTimer	= 0.0f;
-		float kickTimer				= 0.0f;
-		float kickResetTimer		= 0.0f;
-		float trampTimer			= 0.0f;
-		float fireworkTimer			= 0.0f;
-		float bouncerTimer			= 0.0f;
-		float fireTimer				= 0.0f;
+		// Broadphase aggregates for the castles, firework stacks and kicker (self collision per group)
+		bool useAggregates			= true;
+		bool castleSelfCollision	= true;
+		bool fireworkSelfCollision	= true;
+		bool kickerSelfCollision	= false;
+
+		// Level file, and the built-in layout image when there is none
+		string levelPath = "level.mrl";
+		vector<char> levelImage;
+		vector<Joint*> levelJoints;
+		string levelStatus;
+
+		// Timed events
+		TimerWheel timers;
+		TimerId bridgeStop;
+		TimerId fireworkReset;
+		TimerId cannonReload;
+		bool kickReady				= true;
 		bool newBall				= true;
 		bool bridgeSet				= false;
-		bool fired					= true;
 
 		// Object count
 		int objects = 0;
@@ -0,0 +1,379 @@
+#include "Level.h"
+#include <fstream>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Physics engine namespace
+namespace PhysicsEngine
+{
+	// Constructor
+	LevelFile::LevelFile() : data(0), size(0), mapped(false), file_handle(0), mapping_handle(0)
+	{
+	}
+
+	// Destructor
+	LevelFile::~LevelFile()
+	{
+		Close();
+	}
+
+	// Map a level file
+	bool LevelFile::Open(const string& path)
+	{
+		Close();
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < (LONGLONG)sizeof(LevelHeader) || file_size.QuadPart > 0x7fffffff)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (!mapping)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		file_handle = file;
+		mapping_handle = mapping;
+		size = (PxU32)file_size.QuadPart;
+#else
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+			return false;
+
+		struct stat info;
+		if (fstat(file, &info) != 0 || info.st_size < (off_t)sizeof(LevelHeader) || info.st_size > 0x7fffffff)
+		{
+			close(file);
+			return false;
+		}
+
+		void* view = mmap(0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+		data = view == MAP_FAILED ? 0 : (const char*)view;
+		size = (PxU32)info.st_size;
+#endif
+
+		mapped = true;
+		if (!data || !Validate())
+		{
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	// Use a level image in memory
+	bool LevelFile::Open(const void* _data, PxU32 _size)
+	{
+		Close();
+
+		data = (const char*)_data;
+		size = _size;
+		if (!data || size < sizeof(LevelHeader) || !Validate())
+		{
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	// Unmap the file
+	void LevelFile::Close()
+	{
+		if (mapped)
+		{
+#ifdef _WIN32
+			if (data) UnmapViewOfFile(data);
+			if (mapping_handle) CloseHandle((HANDLE)mapping_handle);
+			if (file_handle) CloseHandle((HANDLE)file_handle);
+#else
+			if (data) munmap((void*)data, size);
+#endif
+		}
+
+		data = 0;
+		size = 0;
+		mapped = false;
+		file_handle = 0;
+		mapping_handle = 0;
+	}
+
+	// Check a range lies inside the file
+	static bool RangeFits(const LevelRange& range, PxU32 record_size, PxU32 size)
+	{
+		if (range.offset % 4) return false;
+		if (range.offset > size) return false;
+		return range.count <= (size - range.offset) / record_size;
+	}
+
+	// Check the header, ranges and records
+	bool LevelFile::Validate()
+	{
+		const LevelHeader* header = (const LevelHeader*)data;
+		if (header->magic != level_magic || header->version != level_version || header->size != size)
+			return false;
+
+		if (!RangeFits(header->materials, sizeof(LevelMaterial), size)
+			|| !RangeFits(header->actors, sizeof(LevelActor), size)
+			|| !RangeFits(header->shapes, sizeof(LevelShape), size)
+			|| !RangeFits(header->joints, sizeof(LevelJoint), size)
+			|| !RangeFits(header->prefabs, sizeof(LevelPrefab), size))
+			return false;
+
+		// Materials PhysX accepts
+		const LevelMaterial* materials = (const LevelMaterial*)At(header->materials);
+		for (PxU32 i = 0; i < header->materials.count; i++)
+		{
+			const LevelMaterial& material = materials[i];
+			if (!(material.static_friction >= 0.0f && material.dynamic_friction >= 0.0f && material.restitution >= 0.0f && material.restitution <= 1.0f))
+				return false;
+		}
+
+		// Actors - known type, valid pose and shape run, shapes and a mass for the bodies, a terminated name
+		const LevelActor* actors = (const LevelActor*)At(header->actors);
+		const LevelShape* shapes = (const LevelShape*)At(header->shapes);
+		for (PxU32 i = 0; i < header->actors.count; i++)
+		{
+			const LevelActor& actor = actors[i];
+			if (actor.type >= LEVEL_ACTOR_TYPES || !actor.pose.isValid())
+				return false;
+			if (actor.first_shape > header->shapes.count || actor.shape_count > header->shapes.count - actor.first_shape)
+				return false;
+			if (actor.type != LEVEL_STATIC && !(actor.density > 0.0f))
+				return false;
+			if ((actor.type == LEVEL_DYNAMIC || actor.type == LEVEL_KINEMATIC) && !actor.shape_count)
+				return false;
+			if (actor.name[sizeof(actor.name) - 1] != 0)
+				return false;
+
+			// Planes only on static actors (stadium props are built dynamic and then merged)
+			for (PxU32 j = actor.first_shape; j < actor.first_shape + actor.shape_count; j++)
+				if (shapes[j].type == LEVEL_PLANE && actor.type != LEVEL_STATIC)
+					return false;
+		}
+
+		// Shapes - known type, valid pose, material and a size PhysX accepts (NaN fails every test)
+		for (PxU32 i = 0; i < header->shapes.count; i++)
+		{
+			const LevelShape& shape = shapes[i];
+			if (!shape.local_pose.isValid())
+				return false;
+			if (shape.material >= header->materials.count && header->materials.count)
+				return false;
+
+			switch (shape.type)
+			{
+			case LEVEL_BOX:		if (!(shape.size.x > 0.0f && shape.size.y > 0.0f && shape.size.z > 0.0f)) return false; break;
+			case LEVEL_SPHERE:	if (!(shape.size.x > 0.0f)) return false; break;
+			case LEVEL_CAPSULE:	if (!(shape.size.x > 0.0f && shape.size.y > 0.0f)) return false; break;
+			case LEVEL_PLANE:	break;
+			default:			return false;
+			}
+		}
+
+		// Joints - known type, valid frames, existing actors and at least one of them a body (PhysX rejects static to static or world)
+		const LevelJoint* joints = (const LevelJoint*)At(header->joints);
+		for (PxU32 i = 0; i < header->joints.count; i++)
+		{
+			const LevelJoint& joint = joints[i];
+			if (joint.type >= LEVEL_JOINT_TYPES || !joint.frame0.isValid() || !joint.frame1.isValid())
+				return false;
+			if (joint.actor0 != 0xffffffff && joint.actor0 >= header->actors.count) return false;
+			if (joint.actor1 != 0xffffffff && joint.actor1 >= header->actors.count) return false;
+
+			bool body0 = joint.actor0 != 0xffffffff && (actors[joint.actor0].type == LEVEL_DYNAMIC || actors[joint.actor0].type == LEVEL_KINEMATIC);
+			bool body1 = joint.actor1 != 0xffffffff && (actors[joint.actor1].type == LEVEL_DYNAMIC || actors[joint.actor1].type == LEVEL_KINEMATIC);
+			if (!body0 && !body1) return false;
+		}
+
+		// Prefabs - known type, finite position and params the builders can use
+		const LevelPrefab* prefabs = (const LevelPrefab*)At(header->prefabs);
+		for (PxU32 i = 0; i < header->prefabs.count; i++)
+		{
+			const LevelPrefab& prefab = prefabs[i];
+			if (prefab.type >= LEVEL_PREFAB_TYPES || !prefab.position.isFinite())
+				return false;
+			for (PxU32 j = 0; j < 4; j++)
+				if (!PxIsFinite(prefab.params[j]))
+					return false;
+
+			switch (prefab.type)
+			{
+			case LEVEL_CASTLE:		if (prefab.params[1] < 0.0f || prefab.params[1] > 6.0f) return false; break;
+			case LEVEL_SPINNER:		if (!(prefab.params[0] > 0.0f)) return false; break;
+			case LEVEL_FIREWORKS:	if (!(prefab.params[0] >= 1.0f && prefab.params[0] <= (PxReal)level_max_fireworks)) return false; break;
+			default:				break;
+			}
+		}
+
+		return true;
+	}
+
+	// Start of a range
+	const void* LevelFile::At(const LevelRange& range) const
+	{
+		return data + range.offset;
+	}
+
+	// Materials
+	const LevelMaterial* LevelFile::Materials(PxU32& count) const
+	{
+		count = data ? ((const LevelHeader*)data)->materials.count : 0;
+		return count ? (const LevelMaterial*)At(((const LevelHeader*)data)->materials) : 0;
+	}
+
+	// Actors
+	const LevelActor* LevelFile::Actors(PxU32& count) const
+	{
+		count = data ? ((const LevelHeader*)data)->actors.count : 0;
+		return count ? (const LevelActor*)At(((const LevelHeader*)data)->actors) : 0;
+	}
+
+	// Shapes
+	const LevelShape* LevelFile::Shapes(PxU32& count) const
+	{
+		count = data ? ((const LevelHeader*)data)->shapes.count : 0;
+		return count ? (const LevelShape*)At(((const LevelHeader*)data)->shapes) : 0;
+	}
+
+	// Joints
+	const LevelJoint* LevelFile::Joints(PxU32& count) const
+	{
+		count = data ? ((const LevelHeader*)data)->joints.count : 0;
+		return count ? (const LevelJoint*)At(((const LevelHeader*)data)->joints) : 0;
+	}
+
+	// Prefabs
+	const LevelPrefab* LevelFile::Prefabs(PxU32& count) const
+	{
+		count = data ? ((const LevelHeader*)data)->prefabs.count : 0;
+		return count ? (const LevelPrefab*)At(((const LevelHeader*)data)->prefabs) : 0;
+	}
+
+	// Add a material
+	PxU32 LevelWriter::AddMaterial(PxReal static_friction, PxReal dynamic_friction, PxReal restitution)
+	{
+		LevelMaterial material = { static_friction, dynamic_friction, restitution };
+		materials.push_back(material);
+		return (PxU32)materials.size() - 1;
+	}
+
+	// Start an actor
+	PxU32 LevelWriter::AddActor(LevelActorType type, const PxTransform& pose, const PxVec3& color, const string& name, PxReal density, PxU32 flags)
+	{
+		LevelActor actor;
+		memset(&actor, 0, sizeof(actor));
+		actor.pose = pose;
+		actor.color = color;
+		actor.density = density;
+		actor.type = type;
+		actor.flags = flags;
+		actor.first_shape = (PxU32)shapes.size();
+		actor.shape_count = 0;
+		memcpy(actor.name, name.c_str(), PxMin((PxU32)name.size(), (PxU32)sizeof(actor.name) - 1));
+		actors.push_back(actor);
+		return (PxU32)actors.size() - 1;
+	}
+
+	// Add a shape to the last actor
+	void LevelWriter::AddShape(LevelShapeType type, const PxVec3& size, PxU32 material, const PxTransform& local_pose)
+	{
+		if (!actors.size()) return;
+
+		LevelShape shape = { local_pose, size, (PxU32)type, material };
+		shapes.push_back(shape);
+		actors.back().shape_count++;
+	}
+
+	// Add a revolute joint
+	void LevelWriter::AddRevolute(PxU32 actor0, const PxTransform& frame0, PxU32 actor1, const PxTransform& frame1, PxReal drive)
+	{
+		LevelJoint joint = { frame0, frame1, LEVEL_REVOLUTE, 0, actor0, actor1, drive, 0.0f, 0.0f, 0.0f, 0.0f };
+		joints.push_back(joint);
+	}
+
+	// Limit the last joint
+	void LevelWriter::Limit(PxReal lower, PxReal upper)
+	{
+		if (!joints.size()) return;
+
+		joints.back().flags |= LEVEL_LIMITED;
+		joints.back().lower = lower;
+		joints.back().upper = upper;
+	}
+
+	// Add a distance joint
+	void LevelWriter::AddDistance(PxU32 actor0, const PxTransform& frame0, PxU32 actor1, const PxTransform& frame1, PxReal stiffness, PxReal damping)
+	{
+		LevelJoint joint = { frame0, frame1, LEVEL_DISTANCE, 0, actor0, actor1, 0.0f, 0.0f, 0.0f, stiffness, damping };
+		joints.push_back(joint);
+	}
+
+	// Place a game rig
+	void LevelWriter::AddPrefab(LevelPrefabType type, const PxVec3& position, PxReal p0, PxReal p1, PxReal p2, PxReal p3)
+	{
+		LevelPrefab prefab = { position, (PxU32)type, { p0, p1, p2, p3 } };
+		prefabs.push_back(prefab);
+	}
+
+	// Append a run of records
+	template<class T>
+	static LevelRange Append(vector<char>& image, const vector<T>& records)
+	{
+		LevelRange range = { (PxU32)image.size(), (PxU32)records.size() };
+		if (records.size())
+			image.insert(image.end(), (const char*)records.data(), (const char*)(records.data() + records.size()));
+		return range;
+	}
+
+	// The level image
+	vector<char> LevelWriter::Image() const
+	{
+		vector<char> image(sizeof(LevelHeader));
+
+		LevelHeader header;
+		header.magic = level_magic;
+		header.version = level_version;
+		header.materials = Append(image, materials);
+		header.actors = Append(image, actors);
+		header.shapes = Append(image, shapes);
+		header.joints = Append(image, joints);
+		header.prefabs = Append(image, prefabs);
+		header.size = (PxU32)image.size();
+
+		memcpy(image.data(), &header, sizeof(header));
+		return image;
+	}
+
+	// Write the level file
+	bool LevelWriter::Save(const string& path) const
+	{
+		vector<char> image = Image();
+
+		ofstream file(path, ios::binary);
+		if (!file) return false;
+		file.write(image.data(), image.size());
+		return (bool)file;
+	}
+}
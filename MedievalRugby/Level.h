@@ -0,0 +1,229 @@
+#pragma once
+#include "PhysicsEngine.h"
+
+// Physics engine namespace
+namespace PhysicsEngine
+{
+	// Using the physx and std namespaces
+	using namespace physx;
+	using namespace std;
+
+	// Level file identification ("MRLV") and version
+	static const PxU32 level_magic		= 0x564C524D;
+	static const PxU32 level_version	= 2;
+
+	// Most fireworks in a stack (each stack is one aggregate)
+	static const PxU32 level_max_fireworks = 64;
+
+	// How a level actor is built
+	enum LevelActorType
+	{
+		LEVEL_STATIC,		// Its own static actor
+		LEVEL_STADIUM,		// Merged into the stadium static actor
+		LEVEL_DYNAMIC,		// Dynamic actor
+		LEVEL_KINEMATIC,	// Kinematic actor
+		LEVEL_ACTOR_TYPES
+	};
+
+	// Level actor flags
+	enum LevelActorFlag
+	{
+		LEVEL_TRIGGER	= (1 << 0),
+		LEVEL_HIDDEN	= (1 << 1)
+	};
+
+	// Level shape geometry
+	enum LevelShapeType
+	{
+		LEVEL_BOX,			// size = half extents
+		LEVEL_SPHERE,		// size.x = radius
+		LEVEL_CAPSULE,		// size.x = radius, size.y = half height
+		LEVEL_PLANE,		// the local y / z plane facing +x, size unused (LEVEL_STATIC actors only)
+		LEVEL_SHAPE_TYPES
+	};
+
+	// Level joint types
+	enum LevelJointType
+	{
+		LEVEL_REVOLUTE,
+		LEVEL_DISTANCE,
+		LEVEL_JOINT_TYPES
+	};
+
+	// Level joint flags
+	enum LevelJointFlag
+	{
+		LEVEL_LIMITED = (1 << 0)
+	};
+
+	// Game rigs placed by a level (built by the game scene)
+	enum LevelPrefabType
+	{
+		LEVEL_CASTLE,		// position x / z, params: target offset, colour index
+		LEVEL_GOAL_CASTLE,	// position x / z
+		LEVEL_TEAMS,		// position z
+		LEVEL_KICKER,		// position x / z
+		LEVEL_TRAMPOLINES,	// position x / z
+		LEVEL_SPINNER,		// position x / z, params: height, drive velocity
+		LEVEL_FIREWORKS,	// position x / z, params: count per stack
+		LEVEL_CANNONS,		// position x / z
+		LEVEL_PREFAB_TYPES
+	};
+
+	// A run of records in the file
+	struct LevelRange
+	{
+		PxU32 offset;
+		PxU32 count;
+	};
+
+	// File header - every array is a flat run of the records below
+	struct LevelHeader
+	{
+		PxU32 magic;
+		PxU32 version;
+		PxU32 size;
+		LevelRange materials;
+		LevelRange actors;
+		LevelRange shapes;
+		LevelRange joints;
+		LevelRange prefabs;
+	};
+
+	// Material record
+	struct LevelMaterial
+	{
+		PxReal static_friction;
+		PxReal dynamic_friction;
+		PxReal restitution;
+	};
+
+	// Actor record (shapes are a run of the shape records)
+	struct LevelActor
+	{
+		PxTransform pose;
+		PxVec3 color;
+		PxReal density;
+		PxU32 type;
+		PxU32 flags;
+		PxU32 first_shape;
+		PxU32 shape_count;
+		char name[32];
+	};
+
+	// Shape record
+	struct LevelShape
+	{
+		PxTransform local_pose;
+		PxVec3 size;
+		PxU32 type;
+		PxU32 material;
+	};
+
+	// Joint record (actor index 0xffffffff = the world)
+	struct LevelJoint
+	{
+		PxTransform frame0;
+		PxTransform frame1;
+		PxU32 type;
+		PxU32 flags;
+		PxU32 actor0;
+		PxU32 actor1;
+		PxReal drive;
+		PxReal lower;
+		PxReal upper;
+		PxReal stiffness;
+		PxReal damping;
+	};
+
+	// Prefab record
+	struct LevelPrefab
+	{
+		PxVec3 position;
+		PxU32 type;
+		PxReal params[4];
+	};
+
+	// A level file mapped into memory (or a level image already in memory)
+	class LevelFile
+	{
+	public:
+		// Constructor
+		LevelFile();
+
+		// Destructor
+		~LevelFile();
+
+		// Map a level file (false if missing or malformed)
+		bool Open(const string& path);
+
+		// Use a level image in memory (must outlive the LevelFile)
+		bool Open(const void* data, PxU32 size);
+
+		// Unmap the file
+		void Close();
+
+		// Records
+		const LevelMaterial* Materials(PxU32& count) const;
+		const LevelActor* Actors(PxU32& count) const;
+		const LevelShape* Shapes(PxU32& count) const;
+		const LevelJoint* Joints(PxU32& count) const;
+		const LevelPrefab* Prefabs(PxU32& count) const;
+
+	private:
+		// Check the header, every range against the size and every record against what the game can build
+		bool Validate();
+
+		// Start of a range
+		const void* At(const LevelRange& range) const;
+
+		// Mapped data
+		const char* data;
+		PxU32 size;
+		bool mapped;
+
+		// Platform handles
+		void* file_handle;
+		void* mapping_handle;
+	};
+
+	// Builds a level image - used for the built-in layout and by tools
+	class LevelWriter
+	{
+	public:
+		// Add a material, returns its index
+		PxU32 AddMaterial(PxReal static_friction, PxReal dynamic_friction, PxReal restitution);
+
+		// Start an actor, returns its index (shapes added after belong to it)
+		PxU32 AddActor(LevelActorType type, const PxTransform& pose, const PxVec3& color, const string& name = "", PxReal density = 1.0f, PxU32 flags = 0);
+
+		// Add a shape to the last actor
+		void AddShape(LevelShapeType type, const PxVec3& size, PxU32 material = 0, const PxTransform& local_pose = PxTransform(PxIdentity));
+
+		// Add a revolute joint
+		void AddRevolute(PxU32 actor0, const PxTransform& frame0, PxU32 actor1, const PxTransform& frame1, PxReal drive = 0.0f);
+
+		// Limit the last joint
+		void Limit(PxReal lower, PxReal upper);
+
+		// Add a distance joint (spring)
+		void AddDistance(PxU32 actor0, const PxTransform& frame0, PxU32 actor1, const PxTransform& frame1, PxReal stiffness, PxReal damping);
+
+		// Place a game rig
+		void AddPrefab(LevelPrefabType type, const PxVec3& position, PxReal p0 = 0.0f, PxReal p1 = 0.0f, PxReal p2 = 0.0f, PxReal p3 = 0.0f);
+
+		// The level image
+		vector<char> Image() const;
+
+		// Write the level file
+		bool Save(const string& path) const;
+
+	private:
+		// Records
+		vector<LevelMaterial> materials;
+		vector<LevelActor> actors;
+		vector<LevelShape> shapes;
+		vector<LevelJoint> joints;
+		vector<LevelPrefab> prefabs;
+	};
+}
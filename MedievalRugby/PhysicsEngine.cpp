@@ -1,5 +1,7 @@
 #include "PhysicsEngine.h"
+#include "HighResTimer.h"
 #include <iostream>
+#include <algorithm>
 
 // Pyhsics engine
 namespace PhysicsEngine
@@ -18,6 +20,9 @@ namespace PhysicsEngine
 	PxPhysics* physics = 0;
 	PxCooking* cooking = 0;
 
+	// Scene static actor generations handed out so far (shared, so no two scenes ever report the same one)
+	static PxU32 generations = 0;
+
 	// PhysX functions
 	void PxInit()
 	{
@@ -163,7 +168,7 @@ namespace PhysicsEngine
 	void Actor::Name(const string& new_name)
 	{
 		name = new_name;
-		actor->setName(name.c_str());
+		if (actor) actor->setName(name.c_str());
 	}
 
 	// Get the actor name
@@ -183,6 +188,20 @@ namespace PhysicsEngine
 		}
 	}
 
+	// Show or hide shapes
+	void Actor::Visible(bool value, PxU32 shape_index)
+	{
+		std::vector<PxShape*> shape_list = GetShapes(shape_index);
+		for (PxU32 i = 0; i < shape_list.size(); i++)
+		{
+			UserData* user_data = (UserData*)shape_list[i]->userData;
+			if (!user_data) continue;
+
+			if (value) user_data->flags &= ~UserData::HIDDEN;
+			else user_data->flags |= UserData::HIDDEN;
+		}
+	}
+
 	// Setup filtering
 	void Actor::SetupFiltering(PxU32 filterGroup, PxU32 filterMask, PxU32 shape_index)
 	{
@@ -191,6 +210,64 @@ namespace PhysicsEngine
 			shape_list[i]->setSimulationFilterData(PxFilterData(filterGroup, filterMask, 0, 0));
 	}
 
+	// Copy the shapes of one actor onto another
+	void CopyShapes(PxRigidActor* source, PxRigidActor* target, const PxTransform& offset)
+	{
+		// Vector of shapes
+		std::vector<PxShape*> shapes(source->getNbShapes());
+		source->getShapes((PxShape**)&shapes.front(), (PxU32)shapes.size());
+
+		// Loop through the shapes
+		for (PxU32 i = 0; i < shapes.size(); i++)
+		{
+			// Vector of materials - from the shape
+			std::vector<PxMaterial*> materials(shapes[i]->getNbMaterials());
+			shapes[i]->getMaterials(materials.data(), (PxU32)materials.size());
+
+			// Create the copy
+			PxShape* shape = target->createShape(shapes[i]->getGeometry().any(), materials.data(), (PxU16)materials.size(), shapes[i]->getFlags());
+			shape->setLocalPose(offset * shapes[i]->getLocalPose());
+			shape->setSimulationFilterData(shapes[i]->getSimulationFilterData());
+			shape->setQueryFilterData(shapes[i]->getQueryFilterData());
+			shape->setContactOffset(shapes[i]->getContactOffset());
+			shape->setRestOffset(shapes[i]->getRestOffset());
+
+			// The colour stays with the original actor
+			shape->userData = shapes[i]->userData;
+		}
+	}
+
+	// Move the shapes onto a static actor
+	void Actor::MergeInto(StaticActor* target)
+	{
+		PxRigidActor* source = (PxRigidActor*)actor;
+		PxRigidActor* merged = (PxRigidActor*)target->actor;
+
+		PxU32 first = merged->getNbShapes();
+
+		// Shape poses relative to the static actor
+		CopyShapes(source, merged, merged->getGlobalPose().getInverse() * source->getGlobalPose());
+
+		// The static actor takes the colours over, with render data of its own
+		std::vector<PxShape*> shapes = target->GetShapes();
+		for (PxU32 i = first; i < shapes.size(); i++)
+		{
+			UserData* user_data = new UserData();
+			if (shapes[i]->userData) user_data->flags = ((UserData*)shapes[i]->userData)->flags;
+			shapes[i]->userData = user_data;
+			target->colors.push_back(colors[i - first]);
+		}
+		for (PxU32 i = 0; i < shapes.size(); i++)
+			((UserData*)shapes[i]->userData)->color = &target->colors[i];
+
+		// Drop the original - the prop no longer owns an actor
+		for (PxU32 i = 0; i < colors.size(); i++)
+			delete (UserData*)GetShape(i)->userData;
+		source->release();
+		actor = 0;
+		colors.clear();
+	}
+
 	// Create a dynamic actor
 	DynamicActor::DynamicActor(const PxTransform& pose) : Actor()
 	{
@@ -228,7 +305,26 @@ namespace PhysicsEngine
 	// Set a dynamic actor kinematic
 	void DynamicActor::SetKinematic(bool value, PxU32 index)
 	{
-		((PxRigidDynamic*)actor)->setRigidDynamicFlag(PxRigidDynamicFlag::eKINEMATIC, value);
+		// Baked actors are static, merged ones have none
+		if (actor && actor->isRigidDynamic())
+			((PxRigidDynamic*)actor)->setRigidDynamicFlag(PxRigidDynamicFlag::eKINEMATIC, value);
+	}
+
+	// Rebuild a never-moving prop as a static actor
+	void DynamicActor::Bake()
+	{
+		PxRigidDynamic* dynamic = actor->isRigidDynamic();
+		if (!dynamic) return;
+
+		// Static actor with the same pose and shapes
+		PxRigidStatic* baked = GetPhysics()->createRigidStatic(dynamic->getGlobalPose());
+		CopyShapes(dynamic, baked, PxTransform(PxIdentity));
+		baked->userData = dynamic->userData;
+
+		// Drop the dynamic actor
+		dynamic->release();
+		actor = (PxActor*)baked;
+		actor->setName(name.c_str());
 	}
 
 	// Create a static actor
@@ -262,6 +358,193 @@ namespace PhysicsEngine
 			((UserData*)GetShape(i)->userData)->color = &colors[i];
 	}
 
+	// Queue a pose write
+	void PoseBatch::Pose(PxRigidDynamic* actor, const PxTransform& pose)
+	{
+		Write& write = Find(actor);
+		write.pose = pose;
+		write.flags = (write.flags & ~TARGET) | POSE;
+	}
+
+	// Queue a velocity write
+	void PoseBatch::Velocity(PxRigidDynamic* actor, const PxVec3& linear, const PxVec3& angular)
+	{
+		Write& write = Find(actor);
+		write.linear = linear;
+		write.angular = angular;
+		write.flags |= VELOCITY;
+	}
+
+	// Queue a kinematic target
+	void PoseBatch::KinematicTarget(PxRigidDynamic* actor, const PxTransform& target)
+	{
+		Write& write = Find(actor);
+		write.pose = target;
+		write.flags = (write.flags & ~POSE) | TARGET;
+	}
+
+	// Apply the queued writes
+	void PoseBatch::Apply()
+	{
+		applied = 0;
+		skipped = 0;
+
+		// Loop through the writes
+		for (PxU32 i = 0; i < writes.size(); i++)
+		{
+			Write& write = writes[i];
+			PxRigidDynamic* actor = write.actor;
+			bool kinematic = actor->getRigidDynamicFlags() & PxRigidDynamicFlag::eKINEMATIC;
+
+			// Pose or target
+			if (write.flags & (POSE | TARGET))
+			{
+				PxTransform current = actor->getGlobalPose();
+
+				// Already there - don't dirty the broadphase
+				if (SamePose(current, write.pose))
+					skipped++;
+
+				// Short kinematic moves (or explicit targets) are driven by the solver
+				else if (kinematic && ((write.flags & TARGET) || (current.p - write.pose.p).magnitudeSquared() < target_distance * target_distance))
+				{
+					actor->setKinematicTarget(write.pose);
+					applied++;
+				}
+
+				// Teleport
+				else
+				{
+					actor->setGlobalPose(write.pose);
+					applied++;
+				}
+			}
+
+			// Velocity - kinematic actors take their velocity from the target
+			if (write.flags & VELOCITY)
+			{
+				if (kinematic)
+					skipped++;
+				else if ((actor->getLinearVelocity() - write.linear).magnitudeSquared() < tolerance * tolerance && (actor->getAngularVelocity() - write.angular).magnitudeSquared() < tolerance * tolerance)
+					skipped++;
+				else
+				{
+					actor->setLinearVelocity(write.linear);
+					actor->setAngularVelocity(write.angular);
+					applied++;
+				}
+			}
+		}
+
+		// Done with this frame
+		Clear();
+	}
+
+	// Drop the queued writes
+	void PoseBatch::Clear()
+	{
+		writes.clear();
+		lookup.clear();
+	}
+
+	// Writes applied during the last apply
+	PxU32 PoseBatch::Applied()
+	{
+		return applied;
+	}
+
+	// Writes skipped during the last apply
+	PxU32 PoseBatch::Skipped()
+	{
+		return skipped;
+	}
+
+	// Get the write for an actor
+	PoseBatch::Write& PoseBatch::Find(PxRigidDynamic* actor)
+	{
+		// Existing write
+		std::unordered_map<PxRigidDynamic*, PxU32>::iterator it = lookup.find(actor);
+		if (it != lookup.end())
+			return writes[it->second];
+
+		// New write
+		Write write = { actor, PxTransform(PxIdentity), PxVec3(0.0f), PxVec3(0.0f), 0 };
+		lookup[actor] = (PxU32)writes.size();
+		writes.push_back(write);
+		return writes.back();
+	}
+
+	// Is the pose within tolerance
+	bool PoseBatch::SamePose(const PxTransform& a, const PxTransform& b)
+	{
+		return ((a.p - b.p).magnitudeSquared() < tolerance * tolerance) && (PxAbs(a.q.dot(b.q)) > 1.0f - tolerance * tolerance);
+	}
+
+	// Queue an impulse
+	void ImpulseBatch::Add(PxRigidDynamic* body, const PxVec3& impulse)
+	{
+		bodies.push_back(body);
+		impulses.push_back(impulse);
+	}
+
+	// Queue an impulse per body
+	void ImpulseBatch::Add(PxRigidDynamic* const* _bodies, const PxVec3* _impulses, PxU32 count)
+	{
+		bodies.insert(bodies.end(), _bodies, _bodies + count);
+		impulses.insert(impulses.end(), _impulses, _impulses + count);
+	}
+
+	// Queue the bodies, leaving their impulses to the caller
+	PxVec3* ImpulseBatch::Add(PxRigidDynamic* const* _bodies, PxU32 count)
+	{
+		PxU32 first = (PxU32)impulses.size();
+		bodies.insert(bodies.end(), _bodies, _bodies + count);
+		impulses.resize(first + count);
+		return impulses.data() + first;
+	}
+
+	// Apply the queued impulses
+	void ImpulseBatch::Apply()
+	{
+		applied = 0;
+		skipped = 0;
+
+		for (PxU32 i = 0; i < bodies.size(); i++)
+		{
+			PxRigidDynamic* body = bodies[i];
+			if (!body->getScene() || (body->getRigidDynamicFlags() & PxRigidDynamicFlag::eKINEMATIC))
+			{
+				skipped++;
+				continue;
+			}
+
+			body->addForce(impulses[i], PxForceMode::eIMPULSE);
+			applied++;
+		}
+
+		// Done with this frame (the arrays keep their capacity)
+		Clear();
+	}
+
+	// Drop the queued impulses
+	void ImpulseBatch::Clear()
+	{
+		bodies.clear();
+		impulses.clear();
+	}
+
+	// Impulses applied during the last apply
+	PxU32 ImpulseBatch::Applied()
+	{
+		return applied;
+	}
+
+	// Impulses skipped during the last apply
+	PxU32 ImpulseBatch::Skipped()
+	{
+		return skipped;
+	}
+
 	// Scene methods
 	void Scene::Init()
 	{
@@ -285,8 +568,14 @@ namespace PhysicsEngine
 		// Default gravity
 		px_scene->setGravity(PxVec3(0.0f, -9.81f, 0.0f));
 
-		// User definded initialisation
+		// User definded initialisation (actors inserted in one go), then the setup that needs them in the scene
+		HighResTimer init_timer;
+		init_timer.ResetHighResTimer();
+		if (bulkInsert) BeginBatch();
 		CustomInit();
+		if (bulkInsert) EndBatch();
+		CustomPostInit();
+		init_time = init_timer.GetHighResTimer() / 1000.0f;
 
 		// Not paused
 		pause = false;
@@ -304,27 +593,161 @@ namespace PhysicsEngine
 		// No update when paused
 		if (pause) return;
 
-		// Custom update
+		// Custom update (timed)
+		HighResTimer update_timer;
+		update_timer.ResetHighResTimer();
 		CustomUpdate(dt);
+		custom_update_time += (update_timer.GetHighResTimer() - custom_update_time) * 0.1f;
+
+		// Flush the queued pose writes, then the impulses
+		pose_batch.Apply();
+		impulse_batch.Apply();
 
 		// Simulate the scene
 		px_scene->simulate(dt);
 		px_scene->fetchResults(true);
+
+		// Broadphase pair statistics (rigid bodies, particles and cloth)
+		PxSimulationStatistics stats;
+		px_scene->getSimulationStatistics(stats);
+		for (PxU32 i = 0; i < PxSimulationStatistics::eVOLUME_COUNT; i++)
+		{
+			broadphase_adds += stats.getNbBroadPhaseAdds((PxSimulationStatistics::VolumeType)i);
+			broadphase_removes += stats.getNbBroadPhaseRemoves((PxSimulationStatistics::VolumeType)i);
+		}
 	}
 
 	// Add an actor to the scene
-	void Scene::Add(Actor* actor)
-	{
-		px_scene->addActor(*actor->Get());
+	void Scene::Add(Actor* actor, Aggregate* aggregate)
+	{
+		// addActors only takes rigid actors - cloth goes in on its own even inside a batch
+		if (aggregate) aggregate->Add(actor);
+		else if (batch_depth && actor->Get()->isRigidActor()) pending_actors.push_back(actor->Get());
+		else px_scene->addActor(*actor->Get());
+		RenderListAdd(actor->Get());
+		if (actor->Get()->getType() == PxActorType::eRIGID_STATIC) generation = ++generations;
 		objects++;
 	}
 
+	// Add an aggregate to the scene
+	void Scene::Add(Aggregate* aggregate)
+	{
+		aggregates.push_back(aggregate);
+		if (batch_depth) pending_aggregates.push_back(aggregate->Get());
+		else px_scene->addAggregate(*aggregate->Get());
+	}
+
+	// Start queueing adds
+	void Scene::BeginBatch()
+	{
+		batch_depth++;
+	}
+
+	// Stop queueing adds
+	void Scene::EndBatch()
+	{
+		if (!batch_depth) throw new Exception("PhysicsEngine::Scene::EndBatch, No batch to end.");
+		if (--batch_depth == 0) Flush();
+	}
+
+	// Insert the queued actors with a single call, then the queued aggregates
+	void Scene::Flush()
+	{
+		if (pending_actors.size())
+			px_scene->addActors(&pending_actors[0], (PxU32)pending_actors.size());
+
+		for (PxU32 i = 0; i < pending_aggregates.size(); i++)
+			px_scene->addAggregate(*pending_aggregates[i]);
+
+		pending_actors.clear();
+		pending_aggregates.clear();
+	}
+
+	// Remove an actor from the scene
+	void Scene::Remove(Actor* actor)
+	{
+		// Drop the selection
+		if (selected_actor && (PxActor*)selected_actor == actor->Get())
+		{
+			HighlightOff(selected_actor);
+			selected_actor = 0;
+		}
+
+		// Still queued - never reached the scene
+		vector<PxActor*>::iterator queued = find(pending_actors.begin(), pending_actors.end(), actor->Get());
+		if (queued != pending_actors.end()) pending_actors.erase(queued);
+		else px_scene->removeActor(*actor->Get());
+		RenderListRemove(actor->Get());
+		if (actor->Get()->getType() == PxActorType::eRIGID_STATIC) generation = ++generations;
+		objects--;
+	}
+
+	// Put an actor on the render list
+	void Scene::RenderListAdd(PxActor* actor)
+	{
+		if (render_slots.count(actor))
+			return;
+
+		render_slots[actor] = (PxU32)render_list.size();
+		render_list.push_back(actor);
+	}
+
+	// Take an actor off the render list - the last actor fills its slot
+	void Scene::RenderListRemove(PxActor* actor)
+	{
+		unordered_map<PxActor*, PxU32>::iterator slot = render_slots.find(actor);
+		if (slot == render_slots.end())
+			return;
+
+		PxActor* last = render_list.back();
+		render_list[slot->second] = last;
+		render_slots[last] = slot->second;
+		render_list.pop_back();
+		render_slots.erase(actor);
+	}
+
 	// Get objects count
 	int Scene::ObjectsCount()
 	{
 		return objects;
 	}
 
+	// Get the pose batch
+	PoseBatch& Scene::Poses()
+	{
+		return pose_batch;
+	}
+
+	// Get the impulse batch
+	ImpulseBatch& Scene::Impulses()
+	{
+		return impulse_batch;
+	}
+
+	// Broadphase pairs added since the scene was built
+	PxU32 Scene::BroadPhaseAdds()
+	{
+		return broadphase_adds;
+	}
+
+	// Broadphase pairs removed since the scene was built
+	PxU32 Scene::BroadPhaseRemoves()
+	{
+		return broadphase_removes;
+	}
+
+	// Scene initialisation time (ms)
+	PxReal Scene::InitTime()
+	{
+		return init_time;
+	}
+
+	// Averaged custom update time (us)
+	PxReal Scene::CustomUpdateTime()
+	{
+		return custom_update_time;
+	}
+
 	// Get the scene
 	PxScene* Scene::Get() 
 	{ 
@@ -334,6 +757,17 @@ namespace PhysicsEngine
 	// Reset the scene
 	void Scene::Reset()
 	{
+		pose_batch.Clear();
+		impulse_batch.Clear();
+		batch_depth = 0;
+		pending_actors.clear();
+		pending_aggregates.clear();
+		render_list.clear();
+		render_slots.clear();
+		generation = ++generations;
+		broadphase_adds = 0;
+		broadphase_removes = 0;
+		ReleaseAggregates();
 		px_scene->release();
 		Init();
 	}
@@ -341,9 +775,21 @@ namespace PhysicsEngine
 	// Release the scene
 	void Scene::Release()
 	{
+		ReleaseAggregates();
 		px_scene->release();
 	}
 
+	// Release the aggregates (their actors are left to the scene)
+	void Scene::ReleaseAggregates()
+	{
+		for (PxU32 i = 0; i < aggregates.size(); i++)
+		{
+			aggregates[i]->Get()->release();
+			delete aggregates[i];
+		}
+		aggregates.clear();
+	}
+
 	// Pause the scene
 	void Scene::Pause(bool value)
 	{
@@ -452,6 +898,18 @@ namespace PhysicsEngine
 		return actors;
 	}
 
+	// Get the render list
+	const std::vector<PxActor*>& Scene::RenderList()
+	{
+		return render_list;
+	}
+
+	// Get the static actor generation
+	PxU32 Scene::Generation()
+	{
+		return generation;
+	}
+
 	// Highlight on
 	void Scene::HighlightOn(PxRigidDynamic* actor)
 	{
@@ -492,6 +950,25 @@ namespace PhysicsEngine
 			*((UserData*)shapes[i]->userData)->color = sactor_color_orig[i];
 	}
 
+	// Constructor
+	Aggregate::Aggregate(PxU32 max_size, bool self_collision)
+	{
+		aggregate = GetPhysics()->createAggregate(max_size, self_collision);
+		if (!aggregate) throw new Exception("PhysicsEngine::Aggregate, Could not create the aggregate.");
+	}
+
+	// Add an actor to the aggregate
+	void Aggregate::Add(Actor* actor)
+	{
+		aggregate->addActor(*actor->Get());
+	}
+
+	// Access to the aggregate
+	PxAggregate* Aggregate::Get()
+	{
+		return aggregate;
+	}
+
 	// Constructor
 	Joint::Joint() : joint(0) {}
 
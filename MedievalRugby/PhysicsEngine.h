@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <unordered_map>
 #include "PxPhysicsAPI.h"
 #include "Exception.h"
 #include "Extras\UserData.h"
@@ -30,9 +31,15 @@ namespace PhysicsEngine
 	// Create a new material
 	PxMaterial* CreateMaterial(PxReal sf = 0.0f, PxReal df = 0.0f, PxReal cr = 0.0f);
 
+	// Copy the shapes of one actor onto another
+	void CopyShapes(PxRigidActor* source, PxRigidActor* target, const PxTransform& offset = PxTransform(PxIdentity));
+
 	// Defualt colour
 	static const PxVec3 default_color(0.8f, 0.8f, 0.8f);
 
+	// Forward declaration
+	class StaticActor;
+
 	// Abstract Actor class
 	class Actor
 	{
@@ -70,9 +77,16 @@ namespace PhysicsEngine
 		// Set as trigger
 		void SetTrigger(bool value, PxU32 shape_index = -1);
 
+		// Show or hide shapes (hidden shapes still simulate, e.g. trigger volumes)
+		void Visible(bool value, PxU32 shape_index = -1);
+
 		// Setup filtering
 		void SetupFiltering(PxU32 filterGroup, PxU32 filterMask, PxU32 shape_index = -1);
 
+		// Move the shapes of a never-moving prop onto a static actor (before either is added to the scene)
+		// The static actor owns the shapes and their colours, Get() then returns null
+		void MergeInto(StaticActor* target);
+
 	protected:
 		// The actor
 		PxActor* actor;
@@ -99,6 +113,9 @@ namespace PhysicsEngine
 
 		// Set kinematic
 		void SetKinematic(bool value, PxU32 index = -1);
+
+		// Rebuild a never-moving prop as a static actor with the same shapes (before it is added to the scene)
+		void Bake();
 	};
 
 	// Static actor class
@@ -126,10 +143,139 @@ namespace PhysicsEngine
 		// Constructor
 		Joint();
 
+		// Destructor (the PxJoint is released by its owner)
+		virtual ~Joint() {}
+
 		// Access to the joint
 		PxJoint* Get();
 	};
 
+	// Aggregate class - groups actors into a single broadphase entry
+	class Aggregate
+	{
+	public:
+		// Constructor
+		Aggregate(PxU32 max_size, bool self_collision = true);
+
+		// Add an actor to the aggregate
+		void Add(Actor* actor);
+
+		// Access to the aggregate
+		PxAggregate* Get();
+
+	protected:
+		// The aggregate
+		PxAggregate* aggregate;
+	};
+
+	// Batched pose, velocity and kinematic target writes - applied in one pass before simulate
+	class PoseBatch
+	{
+	public:
+		// Constructor
+		PoseBatch(PxReal _tolerance = 0.001f, PxReal _target_distance = 1.0f) : tolerance(_tolerance), target_distance(_target_distance), applied(0), skipped(0) {}
+
+		// Queue a pose write - kinematic actors are moved by target for short moves, everything else is teleported
+		void Pose(PxRigidDynamic* actor, const PxTransform& pose);
+
+		// Queue a velocity write (ignored for kinematic actors)
+		void Velocity(PxRigidDynamic* actor, const PxVec3& linear, const PxVec3& angular = PxVec3(0.0f));
+
+		// Queue a kinematic target (teleports if the actor is not kinematic)
+		void KinematicTarget(PxRigidDynamic* actor, const PxTransform& target);
+
+		// Apply the queued writes, skipping the redundant ones
+		void Apply();
+
+		// Drop the queued writes
+		void Clear();
+
+		// Writes applied during the last apply
+		PxU32 Applied();
+
+		// Writes skipped during the last apply
+		PxU32 Skipped();
+
+	private:
+		// Write flags
+		enum WriteFlag
+		{
+			POSE		= (1 << 0),
+			VELOCITY	= (1 << 1),
+			TARGET		= (1 << 2)
+		};
+
+		// A single queued write - later writes to the same actor overwrite earlier ones
+		struct Write
+		{
+			PxRigidDynamic* actor;
+			PxTransform pose;
+			PxVec3 linear;
+			PxVec3 angular;
+			PxU32 flags;
+		};
+
+		// Get the write for an actor
+		Write& Find(PxRigidDynamic* actor);
+
+		// Is the pose within tolerance
+		bool SamePose(const PxTransform& a, const PxTransform& b);
+
+		// Queued writes
+		std::vector<Write> writes;
+
+		// Actor to write index
+		std::unordered_map<PxRigidDynamic*, PxU32> lookup;
+
+		// Position / velocity tolerance
+		PxReal tolerance;
+
+		// Kinematic moves shorter than this use a target instead of a teleport
+		PxReal target_distance;
+
+		// Counters
+		PxU32 applied;
+		PxU32 skipped;
+	};
+
+	// Batched impulses - bodies and impulses in parallel arrays, applied in one pass before simulate
+	class ImpulseBatch
+	{
+	public:
+		// Constructor
+		ImpulseBatch() : applied(0), skipped(0) {}
+
+		// Queue an impulse
+		void Add(PxRigidDynamic* body, const PxVec3& impulse);
+
+		// Queue an impulse per body
+		void Add(PxRigidDynamic* const* bodies, const PxVec3* impulses, PxU32 count);
+
+		// Queue the bodies and return their impulse slots to be filled in place (valid until the next add)
+		PxVec3* Add(PxRigidDynamic* const* bodies, PxU32 count);
+
+		// Apply the queued impulses (kinematic bodies and bodies out of the scene are skipped)
+		void Apply();
+
+		// Drop the queued impulses
+		void Clear();
+
+		// Impulses applied during the last apply
+		PxU32 Applied();
+
+		// Impulses skipped during the last apply
+		PxU32 Skipped();
+
+	private:
+		// Queued bodies and their impulses
+		std::vector<PxRigidDynamic*> bodies;
+		std::vector<PxVec3> impulses;
+
+		// Counters
+		PxU32 applied;
+		PxU32 skipped;
+	};
+
 	// Generic scene class
 	class Scene
 	{
@@ -143,14 +289,41 @@ namespace PhysicsEngine
 		// User defined initialisation
 		virtual void CustomInit() {}
 
+		// User defined step once the initial actors are in the scene (e.g. putting bodies to sleep)
+		virtual void CustomPostInit() {}
+
 		// Perform a single simulation step
 		void Update(PxReal dt);
 
 		// User defined update step
 		virtual void CustomUpdate(PxReal dt) {}
 
-		// Add actors
-		void Add(Actor* actor);
+		// Add actors (into the aggregate when one is given)
+		void Add(Actor* actor, Aggregate* aggregate = 0);
+
+		// Add an aggregate (the scene releases it on reset)
+		void Add(Aggregate* aggregate);
+
+		// Add a list of actors with one insertion (into the aggregate when one is given)
+		template<class T> void AddRange(const std::vector<T*>& actors, Aggregate* aggregate = 0)
+		{
+			BeginBatch();
+			for (PxU32 i = 0; i < actors.size(); i++)
+				Add(actors[i], aggregate);
+			EndBatch();
+		}
+
+		// Queue the following adds (batches can be nested)
+		void BeginBatch();
+
+		// Insert the queued actors and aggregates when the outermost batch ends
+		void EndBatch();
+
+		// Insert the queued actors and aggregates now (for actors that must be in the scene, e.g. to sleep)
+		void Flush();
+
+		// Remove actors (the actor is kept and can be added again)
+		void Remove(Actor* actor);
 
 		// Get the PxScene object
 		PxScene* Get();
@@ -179,12 +352,37 @@ namespace PhysicsEngine
 		// List with all actors
 		std::vector<PxActor*> GetAllActors();
 
+		// The actors to render - kept up to date as actors are added and removed, so no list is built per frame
+		const std::vector<PxActor*>& RenderList();
+
+		// Changes whenever static actors are added or removed or the scene is reset (unique across scenes)
+		PxU32 Generation();
+
 		// Get objects count
 		int ObjectsCount();
 
+		// Get the pose batch
+		PoseBatch& Poses();
+
+		// Get the impulse batch
+		ImpulseBatch& Impulses();
+
+		// Broadphase pairs added / removed since the scene was built
+		PxU32 BroadPhaseAdds();
+		PxU32 BroadPhaseRemoves();
+
+		// Scene initialisation time (ms)
+		PxReal InitTime();
+
+		// Custom update time, averaged over recent steps (us)
+		PxReal CustomUpdateTime();
+
 		// Object counter
 		int objects = 0;
 
+		// Insert the actors of the custom initialisation in bulk
+		bool bulkInsert = true;
+
 	protected:
 		// Set highlight on
 		void HighlightOn(PxRigidDynamic* actor);
@@ -192,6 +390,15 @@ namespace PhysicsEngine
 		// Set highlight off
 		void HighlightOff(PxRigidDynamic* actor);
 
+		// Put an actor on the render list
+		void RenderListAdd(PxActor* actor);
+
+		// Take an actor off the render list
+		void RenderListRemove(PxActor* actor);
+
+		// Release the aggregates added to the scene
+		void ReleaseAggregates();
+
 		// PhysX scene object
 		PxScene* px_scene;
 
@@ -206,5 +413,38 @@ namespace PhysicsEngine
 
 		// Filter shader
 		PxSimulationFilterShader filterShader;
+
+		// Pose writes queued during the custom update
+		PoseBatch pose_batch;
+
+		// Impulses queued during the custom update
+		ImpulseBatch impulse_batch;
+
+		// Broadphase pairs added / removed since the scene was built
+		PxU32 broadphase_adds = 0;
+		PxU32 broadphase_removes = 0;
+
+		// Aggregates added to the scene (released with it)
+		std::vector<Aggregate*> aggregates;
+
+		// Open batches
+		PxU32 batch_depth = 0;
+
+		// Actors and aggregates waiting for the batch to end
+		std::vector<PxActor*> pending_actors;
+		std::vector<PxAggregate*> pending_aggregates;
+
+		// Scene initialisation time (ms)
+		PxReal init_time = 0.0f;
+
+		// Averaged custom update time (us)
+		PxReal custom_update_time = 0.0f;
+
+		// Actors to render and the slot of each one in the list
+		std::vector<PxActor*> render_list;
+		std::unordered_map<PxActor*, PxU32> render_slots;
+
+		// Static actor set generation
+		PxU32 generation = 0;
 	};
 }
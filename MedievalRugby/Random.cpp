@@ -0,0 +1,123 @@
+#include "Random.h"
+#include <emmintrin.h>
+
+// Physics engine namespace
+namespace PhysicsEngine
+{
+	// Step four xoshiro128+ streams, returning four floats in [0, 1)
+	static inline __m128 Step(PxU32 state[4][4])
+	{
+		__m128i s0 = _mm_loadu_si128((const __m128i*)state[0]);
+		__m128i s1 = _mm_loadu_si128((const __m128i*)state[1]);
+		__m128i s2 = _mm_loadu_si128((const __m128i*)state[2]);
+		__m128i s3 = _mm_loadu_si128((const __m128i*)state[3]);
+
+		__m128i result = _mm_add_epi32(s0, s3);
+		__m128i t = _mm_slli_epi32(s1, 9);
+		s2 = _mm_xor_si128(s2, s0);
+		s3 = _mm_xor_si128(s3, s1);
+		s1 = _mm_xor_si128(s1, s2);
+		s0 = _mm_xor_si128(s0, s3);
+		s2 = _mm_xor_si128(s2, t);
+		s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+		_mm_storeu_si128((__m128i*)state[0], s0);
+		_mm_storeu_si128((__m128i*)state[1], s1);
+		_mm_storeu_si128((__m128i*)state[2], s2);
+		_mm_storeu_si128((__m128i*)state[3], s3);
+
+		// Top 23 bits as the mantissa of a float in [1, 2)
+		__m128 one_two = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(result, 9), _mm_set1_epi32(0x3f800000)));
+		return _mm_sub_ps(one_two, _mm_set1_ps(1.0f));
+	}
+
+	// Constructor
+	Random::Random(PxU64 seed)
+	{
+		Seed(seed);
+	}
+
+	// Expand the seed with splitmix64 (never leaves a stream all zero)
+	void Random::Seed(PxU64 seed)
+	{
+		for (PxU32 lane = 0; lane < 4; lane++)
+		{
+			for (PxU32 word = 0; word < 4; word += 2)
+			{
+				PxU64 z = (seed += 0x9e3779b97f4a7c15ULL);
+				z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+				z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+				z = z ^ (z >> 31);
+				state[word][lane] = (PxU32)z;
+				state[word + 1][lane] = (PxU32)(z >> 32);
+			}
+
+			if (!(state[0][lane] | state[1][lane] | state[2][lane] | state[3][lane]))
+				state[0][lane] = 1;
+		}
+		cached = 0;
+	}
+
+	// Uniform float in [0, 1)
+	PxReal Random::Float()
+	{
+		if (!cached)
+		{
+			Next(cache);
+			cached = 4;
+		}
+		return cache[--cached];
+	}
+
+	// Uniform float in [min, max)
+	PxReal Random::Range(PxReal min, PxReal max)
+	{
+		return min + Float() * (max - min);
+	}
+
+	// Fill an array with uniform floats
+	void Random::Fill(PxReal* out, PxU32 count, PxReal min, PxReal max)
+	{
+		const __m128 offset = _mm_set1_ps(min);
+		const __m128 scale = _mm_set1_ps(max - min);
+
+		PxU32 i = 0;
+		for (; i + 4 <= count; i += 4)
+			_mm_storeu_ps(out + i, _mm_add_ps(offset, _mm_mul_ps(Step(state), scale)));
+
+		// Tail
+		if (i < count)
+		{
+			PxReal tail[4];
+			_mm_storeu_ps(tail, _mm_add_ps(offset, _mm_mul_ps(Step(state), scale)));
+			for (PxU32 j = 0; i < count; i++, j++)
+				out[i] = tail[j];
+		}
+	}
+
+	// Fill an array with random vectors
+	void Random::Vectors(PxVec3* out, PxU32 count, const PxVec3& min, const PxVec3& max)
+	{
+		const __m128 offset_x = _mm_set1_ps(min.x), offset_y = _mm_set1_ps(min.y), offset_z = _mm_set1_ps(min.z);
+		const __m128 scale_x = _mm_set1_ps(max.x - min.x), scale_y = _mm_set1_ps(max.y - min.y), scale_z = _mm_set1_ps(max.z - min.z);
+
+		// Four vectors per step, one stream per vector
+		PxReal x[4], y[4], z[4];
+		for (PxU32 i = 0; i < count; i += 4)
+		{
+			_mm_storeu_ps(x, _mm_add_ps(offset_x, _mm_mul_ps(Step(state), scale_x)));
+			_mm_storeu_ps(y, _mm_add_ps(offset_y, _mm_mul_ps(Step(state), scale_y)));
+			_mm_storeu_ps(z, _mm_add_ps(offset_z, _mm_mul_ps(Step(state), scale_z)));
+
+			PxU32 n = PxMin(count - i, 4u);
+			for (PxU32 j = 0; j < n; j++)
+				out[i + j] = PxVec3(x[j], y[j], z[j]);
+		}
+	}
+
+	// Step the streams
+	void Random::Next(PxReal* out)
+	{
+		_mm_storeu_ps(out, Step(state));
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "PxPhysicsAPI.h"
+
+// Physics engine namespace
+namespace PhysicsEngine
+{
+	// Using the physx namespace
+	using namespace physx;
+
+	// Four xoshiro128+ streams stepped together with SSE2 - seeded per owner, so scenes don't share (or lock) a global generator
+	class Random
+	{
+	public:
+		// Constructor
+		Random(PxU64 seed = 0x9e3779b97f4a7c15ULL);
+
+		// Restart the streams from a seed
+		void Seed(PxU64 seed);
+
+		// Uniform float in [0, 1)
+		PxReal Float();
+
+		// Uniform float in [min, max)
+		PxReal Range(PxReal min, PxReal max);
+
+		// Fill an array with uniform floats in [min, max), four at a time
+		void Fill(PxReal* out, PxU32 count, PxReal min, PxReal max);
+
+		// Fill an array with vectors uniform in the box [min, max), every component drawn on its own
+		void Vectors(PxVec3* out, PxU32 count, const PxVec3& min, const PxVec3& max);
+
+	private:
+		// Step the four streams, writing four floats in [0, 1)
+		void Next(PxReal* out);
+
+		// Stream state (word, lane) - unaligned loads, so the owner needs no special alignment
+		PxU32 state[4][4];
+
+		// Floats left over from the last step (used by Float)
+		PxReal cache[4];
+		PxU32 cached;
+	};
+}
@@ -0,0 +1,166 @@
+#include "RegionManager.h"
+#include <xmmintrin.h>
+
+// Physics engine namespace
+namespace PhysicsEngine
+{
+	// Constructor
+	RegionManager::RegionManager(PxReal _sleep_distance, PxReal _despawn_distance, PxReal _sleep_speed) :
+		pitch(PxBounds3::empty()), stadium(PxBounds3::empty()), sleep_distance(_sleep_distance), despawn_distance(_despawn_distance), sleep_speed(_sleep_speed), ground(0.0f), rest_height(3.0f), sleeping(0), removed(0)
+	{
+	}
+
+	// Set the bounds
+	void RegionManager::Bounds(const PxBounds3& _pitch, const PxBounds3& _stadium)
+	{
+		pitch = _pitch;
+		stadium = _stadium;
+	}
+
+	// Set the sleep distance
+	void RegionManager::SleepDistance(PxReal value)
+	{
+		sleep_distance = value;
+	}
+
+	// Set the despawn distance
+	void RegionManager::DespawnDistance(PxReal value)
+	{
+		despawn_distance = value;
+	}
+
+	// Set the ground
+	void RegionManager::Ground(PxReal height, PxReal _rest_height)
+	{
+		ground = height;
+		rest_height = _rest_height;
+	}
+
+	// Track an entity
+	void RegionManager::Track(PxU32 entity, RegionPolicy _policy)
+	{
+		if (entity >= policy.size()) policy.resize(entity + 1, untracked);
+		policy[entity] = (PxU8)_policy;
+	}
+
+	// Stop tracking everything
+	void RegionManager::Clear()
+	{
+		policy.clear();
+		parked.clear();
+		sleeping = 0;
+		removed = 0;
+	}
+
+	// Check all tracked entities
+	void RegionManager::Update(Scene* scene, EntityTable& entities)
+	{
+		parked.clear();
+		sleeping = 0;
+
+		// Entities added after the last track are untracked, the ones added after the last gather skipped
+		PxU32 count = PxMin(entities.Size(), (PxU32)entities.pos_x.size());
+		if (policy.size() < count) policy.resize(count, untracked);
+		result.resize(entities.pos_x.size());
+		const float* pos_x = entities.pos_x.empty() ? 0 : &entities.pos_x[0];
+		const float* pos_y = entities.pos_y.empty() ? 0 : &entities.pos_y[0];
+		const float* pos_z = entities.pos_z.empty() ? 0 : &entities.pos_z[0];
+
+		// Squared distance outside both boxes, four bodies at a time
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 p_min_x = _mm_set1_ps(pitch.minimum.x), p_min_y = _mm_set1_ps(pitch.minimum.y), p_min_z = _mm_set1_ps(pitch.minimum.z);
+		const __m128 p_max_x = _mm_set1_ps(pitch.maximum.x), p_max_y = _mm_set1_ps(pitch.maximum.y), p_max_z = _mm_set1_ps(pitch.maximum.z);
+		const __m128 s_min_x = _mm_set1_ps(stadium.minimum.x), s_min_y = _mm_set1_ps(stadium.minimum.y), s_min_z = _mm_set1_ps(stadium.minimum.z);
+		const __m128 s_max_x = _mm_set1_ps(stadium.maximum.x), s_max_y = _mm_set1_ps(stadium.maximum.y), s_max_z = _mm_set1_ps(stadium.maximum.z);
+		const __m128 sleep_sq = _mm_set1_ps(sleep_distance * sleep_distance);
+		const __m128 despawn_sq = _mm_set1_ps(despawn_distance * despawn_distance);
+		for (PxU32 i = 0; i < result.size(); i += 4)
+		{
+			__m128 x = _mm_loadu_ps(pos_x + i);
+			__m128 y = _mm_loadu_ps(pos_y + i);
+			__m128 z = _mm_loadu_ps(pos_z + i);
+
+			// Pitch
+			__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(p_min_x, x), _mm_sub_ps(x, p_max_x)), zero);
+			__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(p_min_y, y), _mm_sub_ps(y, p_max_y)), zero);
+			__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(p_min_z, z), _mm_sub_ps(z, p_max_z)), zero);
+			__m128 pitch_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+			// Stadium
+			dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(s_min_x, x), _mm_sub_ps(x, s_max_x)), zero);
+			dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(s_min_y, y), _mm_sub_ps(y, s_max_y)), zero);
+			dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(s_min_z, z), _mm_sub_ps(z, s_max_z)), zero);
+			__m128 stadium_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+			// Classify
+			int sleep_mask = _mm_movemask_ps(_mm_cmpgt_ps(pitch_sq, sleep_sq));
+			int despawn_mask = _mm_movemask_ps(_mm_cmpgt_ps(stadium_sq, despawn_sq));
+			for (PxU32 j = 0; j < 4; j++)
+				result[i + j] = (PxU8)(((sleep_mask >> j) & 1) | (((despawn_mask >> j) & 1) << 1));
+		}
+
+		// Act on the tracked entities in the scene and outside the bounds
+		for (PxU32 i = 0; i < count; i++)
+		{
+			if (!result[i] || policy[i] == untracked || !(entities.flags[i] & ENTITY_IN_SCENE))
+				continue;
+
+			// Past the despawn distance
+			if ((result[i] & 2) && policy[i] != REGION_SLEEP)
+			{
+				if (policy[i] == REGION_PARK)
+					parked.push_back(entities.group[i]);
+				else
+				{
+					scene->Remove(entities.actor[i]);
+					entities.flags[i] = 0;
+				}
+				removed++;
+				continue;
+			}
+
+			// Past the sleep distance - kinematic actors can't sleep
+			if (entities.flags[i] & ENTITY_KINEMATIC)
+				continue;
+
+			// Put resting bodies to sleep - slow, not turning or falling, and near the ground (a body at the top of its arc is slow too)
+			if (!(entities.flags[i] & ENTITY_SLEEPING) && Resting(entities, i))
+			{
+				entities.body[i]->putToSleep();
+				entities.flags[i] |= ENTITY_SLEEPING;
+			}
+
+			if (entities.flags[i] & ENTITY_SLEEPING)
+				sleeping++;
+		}
+	}
+
+	// Slow, not turning or falling and near the ground
+	bool RegionManager::Resting(EntityTable& entities, PxU32 entity)
+	{
+		if (entities.pos_y[entity] - ground > rest_height)
+			return false;
+
+		PxVec3 linear = entities.body[entity]->getLinearVelocity();
+		return linear.magnitudeSquared() < sleep_speed * sleep_speed && PxAbs(linear.y) < sleep_speed * 0.25f
+			&& entities.body[entity]->getAngularVelocity().magnitudeSquared() < sleep_speed * sleep_speed;
+	}
+
+	// Parked ids
+	const vector<int>& RegionManager::Parked()
+	{
+		return parked;
+	}
+
+	// Tracked bodies asleep past the sleep distance
+	PxU32 RegionManager::Sleeping()
+	{
+		return sleeping;
+	}
+
+	// Bodies parked or despawned so far
+	PxU32 RegionManager::Removed()
+	{
+		return removed;
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "EntityTable.h"
+
+// Physics engine namespace
+namespace PhysicsEngine
+{
+	// Using the physx and std namespaces
+	using namespace physx;
+	using namespace std;
+
+	// What happens to a body that leaves the play area
+	enum RegionPolicy
+	{
+		REGION_SLEEP,		// Forced asleep once resting (slow and near the ground) past the sleep distance
+		REGION_PARK,		// Reported through Parked() so the owner can recycle it
+		REGION_DESPAWN		// Removed from the scene
+	};
+
+	// Checks tracked bodies against the pitch and stadium bounds every step
+	class RegionManager
+	{
+	public:
+		// Constructor
+		RegionManager(PxReal _sleep_distance = 10.0f, PxReal _despawn_distance = 50.0f, PxReal _sleep_speed = 2.0f);
+
+		// Set the pitch and stadium bounds
+		void Bounds(const PxBounds3& _pitch, const PxBounds3& _stadium);
+
+		// Set the distance past the pitch after which resting bodies are put to sleep
+		void SleepDistance(PxReal value);
+
+		// Set the ground height and how far above it a body counts as resting
+		void Ground(PxReal height, PxReal rest_height);
+
+		// Set the distance past the stadium after which bodies are parked or despawned
+		void DespawnDistance(PxReal value);
+
+		// Track an entity of the table
+		void Track(PxU32 entity, RegionPolicy policy);
+
+		// Stop tracking everything
+		void Clear();
+
+		// Check all tracked entities in one pass (positions and flags from the last gather)
+		void Update(Scene* scene, EntityTable& entities);
+
+		// Groups of the REGION_PARK entities that left the stadium this step
+		const vector<int>& Parked();
+
+		// Tracked bodies asleep past the sleep distance
+		PxU32 Sleeping();
+
+		// Bodies parked or despawned so far
+		PxU32 Removed();
+
+	private:
+		// Is a body resting? (slow, not turning or falling, and near the ground)
+		bool Resting(EntityTable& entities, PxU32 entity);
+
+		// Policy of every entity (untracked for the ones never tracked)
+		static const PxU8 untracked = 0xff;
+		vector<PxU8> policy;
+
+		// Per entity result: bit 0 = past the sleep distance, bit 1 = past the despawn distance
+		vector<PxU8> result;
+
+		// Parked groups
+		vector<int> parked;
+
+		// Bounds
+		PxBounds3 pitch;
+		PxBounds3 stadium;
+
+		// Distances
+		PxReal sleep_distance;
+		PxReal despawn_distance;
+		PxReal sleep_speed;
+
+		// Ground and resting height above it
+		PxReal ground;
+		PxReal rest_height;
+
+		// Counters
+		PxU32 sleeping;
+		PxU32 removed;
+	};
+}
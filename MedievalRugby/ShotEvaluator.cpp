@@ -0,0 +1,378 @@
+#include "ShotEvaluator.h"
+#include <fstream>
+#include <random>
+
+// Physics engine namespace
+namespace PhysicsEngine
+{
+	// Kick time step and the longest a ball is followed
+	static const PxReal shot_step = 1.0f / 60.0f;
+	static const PxU32 shot_max_steps = 360;
+
+	// Constructor
+	ShotEvaluator::ShotEvaluator(PxU32 _workers, PxSimulationFilterShader _filter_shader) :
+		arm_length(6.0f), launch_angle(PxPi / 4.0f), aim_spread(0.05f), power_spread(2.0f), kicks_per_cell(0), next_kick(0), done_kicks(0), running(false), worker_count(_workers), filter_shader(_filter_shader)
+	{
+		if (!worker_count)
+		{
+			PxU32 hardware = thread::hardware_concurrency();
+			worker_count = hardware > 1 ? hardware - 1 : 1;
+		}
+	}
+
+	// Destructor
+	ShotEvaluator::~ShotEvaluator()
+	{
+		Release();
+	}
+
+	// Make shared copies of an actor's shapes
+	ShotEvaluator::Source ShotEvaluator::Share(PxRigidActor* actor)
+	{
+		Source source;
+		source.pose = actor->getGlobalPose();
+		source.mass = 0.0f;
+		source.inertia = PxVec3(0.0f, 0.0f, 0.0f);
+		source.mass_pose = PxTransform(PxIdentity);
+
+		vector<PxShape*> shapes(actor->getNbShapes());
+		actor->getShapes(shapes.data(), (PxU32)shapes.size());
+
+		for (PxU32 i = 0; i < shapes.size(); i++)
+		{
+			// Triggers are replaced by the outcome regions
+			if (shapes[i]->getFlags() & PxShapeFlag::eTRIGGER_SHAPE)
+				continue;
+
+			vector<PxMaterial*> materials(shapes[i]->getNbMaterials());
+			shapes[i]->getMaterials(materials.data(), (PxU32)materials.size());
+
+			PxShape* shape = GetPhysics()->createShape(shapes[i]->getGeometry().any(), materials.data(), (PxU16)materials.size(), false, shapes[i]->getFlags());
+			shape->setLocalPose(shapes[i]->getLocalPose());
+			shape->setSimulationFilterData(shapes[i]->getSimulationFilterData());
+			shape->setContactOffset(shapes[i]->getContactOffset());
+			shape->setRestOffset(shapes[i]->getRestOffset());
+			source.shapes.push_back(shape);
+		}
+
+		if (actor->isRigidDynamic())
+		{
+			PxRigidDynamic* body = (PxRigidDynamic*)actor;
+			source.mass = body->getMass();
+			source.inertia = body->getMassSpaceInertiaTensor();
+			source.mass_pose = body->getCMassLocalPose();
+		}
+
+		return source;
+	}
+
+	// Static geometry
+	void ShotEvaluator::Static(PxRigidActor* actor)
+	{
+		statics.push_back(Share(actor));
+	}
+
+	// Obstacles
+	void ShotEvaluator::Obstacle(PxRigidDynamic* actor)
+	{
+		obstacles.push_back(Share(actor));
+	}
+
+	// Ball
+	void ShotEvaluator::Projectile(PxRigidDynamic* actor)
+	{
+		balls.push_back(Share(actor));
+	}
+
+	// Goal region
+	void ShotEvaluator::Goal(const PxBounds3& bounds)
+	{
+		goals.push_back(bounds);
+	}
+
+	// Target region
+	void ShotEvaluator::Target(const PxBounds3& bounds, PxU32 ball_group)
+	{
+		targets.push_back(bounds);
+		target_groups.push_back(ball_group);
+	}
+
+	// Kick model
+	void ShotEvaluator::Kick(PxReal _arm_length, PxReal _launch_angle, PxReal _aim_spread, PxReal _power_spread)
+	{
+		arm_length = _arm_length;
+		launch_angle = _launch_angle;
+		aim_spread = _aim_spread;
+		power_spread = _power_spread;
+	}
+
+	// Add a cell
+	void ShotEvaluator::Cell(const PxVec3& position, int power)
+	{
+		ShotCell cell = { position, power, 0, 0, 0 };
+		cells.push_back(cell);
+	}
+
+	// Build a worker's scene
+	void ShotEvaluator::Build(Worker& worker)
+	{
+		// Simulated on the worker thread itself
+		PxSceneDesc sceneDesc(GetPhysics()->getTolerancesScale());
+		worker.dispatcher = PxDefaultCpuDispatcherCreate(0);
+		sceneDesc.cpuDispatcher = worker.dispatcher;
+		sceneDesc.filterShader = filter_shader;
+		sceneDesc.gravity = PxVec3(0.0f, -9.81f, 0.0f);
+		worker.scene = GetPhysics()->createScene(sceneDesc);
+		if (!worker.scene) throw new Exception("ShotEvaluator::Build, Could not create a worker scene.");
+
+		// Static geometry
+		for (PxU32 i = 0; i < statics.size(); i++)
+		{
+			PxRigidStatic* actor = GetPhysics()->createRigidStatic(statics[i].pose);
+			for (PxU32 j = 0; j < statics[i].shapes.size(); j++)
+				actor->attachShape(*statics[i].shapes[j]);
+			worker.scene->addActor(*actor);
+		}
+
+		// Obstacles
+		for (PxU32 i = 0; i < obstacles.size(); i++)
+		{
+			PxRigidDynamic* actor = GetPhysics()->createRigidDynamic(obstacles[i].pose);
+			for (PxU32 j = 0; j < obstacles[i].shapes.size(); j++)
+				actor->attachShape(*obstacles[i].shapes[j]);
+			actor->setMass(obstacles[i].mass);
+			actor->setMassSpaceInertiaTensor(obstacles[i].inertia);
+			actor->setCMassLocalPose(obstacles[i].mass_pose);
+			worker.scene->addActor(*actor);
+			worker.obstacles.push_back(actor);
+		}
+
+		// Balls, parked until kicked
+		for (PxU32 i = 0; i < balls.size(); i++)
+		{
+			PxRigidDynamic* actor = GetPhysics()->createRigidDynamic(balls[i].pose);
+			for (PxU32 j = 0; j < balls[i].shapes.size(); j++)
+				actor->attachShape(*balls[i].shapes[j]);
+			actor->setMass(balls[i].mass);
+			actor->setMassSpaceInertiaTensor(balls[i].inertia);
+			actor->setCMassLocalPose(balls[i].mass_pose);
+			worker.scene->addActor(*actor);
+			worker.balls.push_back(actor);
+			Park(worker, i);
+		}
+
+		// Per worker counts, merged once done
+		worker.goals.assign(cells.size(), 0);
+		worker.targets.assign(cells.size(), 0);
+	}
+
+	// Start kicking
+	void ShotEvaluator::Start(PxU32 _kicks_per_cell)
+	{
+		if (running || !cells.size() || !balls.size())
+			return;
+
+		kicks_per_cell = _kicks_per_cell;
+		next_kick = 0;
+		done_kicks = 0;
+		for (PxU32 i = 0; i < cells.size(); i++)
+			cells[i].kicks = cells[i].goals = cells[i].targets = 0;
+
+		// PhysX objects are created here, the workers only simulate
+		for (PxU32 i = 0; i < worker_count; i++)
+		{
+			workers.push_back(new Worker());
+			Build(*workers.back());
+		}
+
+		running = true;
+		for (PxU32 i = 0; i < workers.size(); i++)
+			workers[i]->runner = thread(&ShotEvaluator::Run, this, i);
+	}
+
+	// Worker loop
+	void ShotEvaluator::Run(PxU32 index)
+	{
+		Worker& worker = *workers[index];
+		PxU32 total = (PxU32)cells.size() * kicks_per_cell;
+
+		// Own generator per worker - the same map every run
+		mt19937 random(1234u + index);
+		uniform_real_distribution<PxReal> spread(-1.0f, 1.0f);
+
+		while (running)
+		{
+			PxU32 kick = next_kick++;
+			if (kick >= total)
+				break;
+
+			PxU32 c = kick / kicks_per_cell;
+			PxReal yaw = spread(random) * aim_spread;
+			PxReal power = cells[c].power + spread(random) * power_spread;
+
+			switch (Shoot(worker, kick % balls.size(), cells[c], yaw, power))
+			{
+			case SHOT_GOAL: worker.goals[c]++; break;
+			case SHOT_TARGET: worker.targets[c]++; break;
+			default: break;
+			}
+
+			done_kicks++;
+		}
+	}
+
+	// Park a ball below the pitch, one spot per ball, without gravity
+	void ShotEvaluator::Park(Worker& worker, PxU32 ball)
+	{
+		PxRigidDynamic* actor = worker.balls[ball];
+		actor->setActorFlag(PxActorFlag::eDISABLE_GRAVITY, true);
+		actor->setGlobalPose(PxTransform(PxVec3(100.0f * ball, -1000.0f, 0.0f)));
+		actor->setLinearVelocity(PxVec3(0.0f, 0.0f, 0.0f));
+		actor->setAngularVelocity(PxVec3(0.0f, 0.0f, 0.0f));
+		actor->putToSleep();
+	}
+
+	// Kick once
+	ShotOutcome ShotEvaluator::Shoot(Worker& worker, PxU32 ball, const ShotCell& cell, PxReal yaw, PxReal power)
+	{
+		// Put the castles back
+		for (PxU32 i = 0; i < worker.obstacles.size(); i++)
+		{
+			PxRigidDynamic* obstacle = worker.obstacles[i];
+			if (obstacle->isSleeping() && obstacle->getGlobalPose().p == obstacles[i].pose.p)
+				continue;
+
+			obstacle->setGlobalPose(obstacles[i].pose);
+			obstacle->setLinearVelocity(PxVec3(0.0f, 0.0f, 0.0f));
+			obstacle->setAngularVelocity(PxVec3(0.0f, 0.0f, 0.0f));
+			obstacle->putToSleep();
+		}
+
+		// Launch - same model as the trajectory preview
+		PxRigidDynamic* actor = worker.balls[ball];
+		PxU32 group = balls[ball].shapes.size() ? balls[ball].shapes[0]->getSimulationFilterData().word0 : 0;
+		PxQuat aim(yaw, PxVec3(0.0f, 1.0f, 0.0f));
+		PxVec3 direction = aim.rotate(PxVec3(0.0f, PxSin(launch_angle), -PxCos(launch_angle)));
+		actor->setActorFlag(PxActorFlag::eDISABLE_GRAVITY, false);
+		actor->setGlobalPose(PxTransform(cell.position, PxQuat(PxPi / 2.0f, PxVec3(1.0f, 0.0f, 0.0f))));
+		actor->setLinearVelocity(direction * (power / 10.0f) * arm_length);
+		actor->setAngularVelocity(PxVec3(0.0f, 0.0f, 0.0f));
+		actor->wakeUp();
+
+		ShotOutcome outcome = SHOT_MISS;
+		for (PxU32 step = 0; step < shot_max_steps && running && outcome == SHOT_MISS; step++)
+		{
+			worker.scene->simulate(shot_step);
+			worker.scene->fetchResults(true);
+
+			PxBounds3 bounds = actor->getWorldBounds();
+			for (PxU32 i = 0; i < goals.size() && outcome == SHOT_MISS; i++)
+				if (goals[i].intersects(bounds)) outcome = SHOT_GOAL;
+
+			// Only the team the target falls for scores a hit
+			for (PxU32 i = 0; i < targets.size() && outcome == SHOT_MISS; i++)
+				if ((target_groups[i] & group) && targets[i].intersects(bounds)) outcome = SHOT_TARGET;
+
+			// Stopped, or out of the stadium
+			if (actor->isSleeping() || bounds.minimum.y < -5.0f)
+				break;
+		}
+
+		Park(worker, ball);
+		return outcome;
+	}
+
+	// All kicks done?
+	bool ShotEvaluator::Done()
+	{
+		if (!running || done_kicks < cells.size() * kicks_per_cell)
+			return false;
+
+		// Merge the per worker counts once
+		running = false;
+		for (PxU32 i = 0; i < workers.size(); i++)
+		{
+			workers[i]->runner.join();
+			for (PxU32 c = 0; c < cells.size(); c++)
+			{
+				cells[c].goals += workers[i]->goals[c];
+				cells[c].targets += workers[i]->targets[c];
+			}
+		}
+		for (PxU32 c = 0; c < cells.size(); c++)
+			cells[c].kicks = kicks_per_cell;
+
+		return true;
+	}
+
+	// Fraction done
+	PxReal ShotEvaluator::Progress()
+	{
+		PxU32 total = (PxU32)cells.size() * kicks_per_cell;
+		return total ? (PxReal)done_kicks / (PxReal)total : 0.0f;
+	}
+
+	// Probability map
+	const vector<ShotCell>& ShotEvaluator::Cells()
+	{
+		return cells;
+	}
+
+	// Write the map
+	bool ShotEvaluator::Write(const string& path)
+	{
+		ofstream file(path);
+		if (!file) return false;
+
+		// What the headless copies leave out
+		file << "# kicks alternate the team balls; draw bridge, spinners and trampolines are frozen where they were when the map started\n";
+		file << "x,z,power,kicks,goal,target,miss\n";
+		for (PxU32 i = 0; i < cells.size(); i++)
+		{
+			const ShotCell& cell = cells[i];
+			PxReal kicks = cell.kicks ? (PxReal)cell.kicks : 1.0f;
+			file << cell.position.x << "," << cell.position.z << "," << cell.power << "," << cell.kicks << ","
+				<< cell.goals / kicks << "," << cell.targets / kicks << "," << (cell.kicks - cell.goals - cell.targets) / kicks << "\n";
+		}
+
+		return true;
+	}
+
+	// Release everything
+	void ShotEvaluator::Release()
+	{
+		running = false;
+		for (PxU32 i = 0; i < workers.size(); i++)
+		{
+			if (workers[i]->runner.joinable())
+				workers[i]->runner.join();
+
+			// Scenes do not release their actors
+			vector<PxActor*> actors(workers[i]->scene->getNbActors(PxActorTypeSelectionFlag::eRIGID_STATIC | PxActorTypeSelectionFlag::eRIGID_DYNAMIC));
+			if (actors.size())
+				workers[i]->scene->getActors(PxActorTypeSelectionFlag::eRIGID_STATIC | PxActorTypeSelectionFlag::eRIGID_DYNAMIC, actors.data(), (PxU32)actors.size());
+			for (PxU32 j = 0; j < actors.size(); j++)
+				actors[j]->release();
+
+			workers[i]->scene->release();
+			workers[i]->dispatcher->release();
+			delete workers[i];
+		}
+		workers.clear();
+
+		// Drop the shared shapes
+		for (PxU32 i = 0; i < statics.size(); i++)
+			for (PxU32 j = 0; j < statics[i].shapes.size(); j++)
+				statics[i].shapes[j]->release();
+		for (PxU32 i = 0; i < obstacles.size(); i++)
+			for (PxU32 j = 0; j < obstacles[i].shapes.size(); j++)
+				obstacles[i].shapes[j]->release();
+		for (PxU32 i = 0; i < balls.size(); i++)
+			for (PxU32 j = 0; j < balls[i].shapes.size(); j++)
+				balls[i].shapes[j]->release();
+
+		statics.clear();
+		obstacles.clear();
+		balls.clear();
+	}
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include "PhysicsEngine.h"
+#include <atomic>
+#include <thread>
+
+// Physics engine namespace
+namespace PhysicsEngine
+{
+	// Using the physx and std namespaces
+	using namespace physx;
+	using namespace std;
+
+	// How a kick ended
+	enum ShotOutcome
+	{
+		SHOT_MISS,
+		SHOT_GOAL,
+		SHOT_TARGET
+	};
+
+	// One cell of the probability map - a kicker position and power
+	struct ShotCell
+	{
+		PxVec3 position;
+		int power;
+		PxU32 kicks;
+		PxU32 goals;
+		PxU32 targets;
+	};
+
+	// Runs batches of kicks in parallel headless copies of the pitch and builds a probability map
+	class ShotEvaluator
+	{
+	public:
+		// Constructor (0 workers = one per hardware thread)
+		ShotEvaluator(PxU32 _workers = 0, PxSimulationFilterShader _filter_shader = PxDefaultSimulationFilterShader);
+
+		// Destructor
+		~ShotEvaluator();
+
+		// Static geometry - shapes are shared by every worker
+		void Static(PxRigidActor* actor);
+
+		// Bodies put back where they were before every kick (castle bricks) - shapes are shared by every worker
+		void Obstacle(PxRigidDynamic* actor);
+
+		// A ball (one per team, kicks take turns with them) - shapes are shared by every worker
+		void Projectile(PxRigidDynamic* actor);
+
+		// Region that counts as a goal
+		void Goal(const PxBounds3& bounds);
+
+		// Region that counts as a castle target hit for balls in the filter group (the other team's balls only bounce off)
+		void Target(const PxBounds3& bounds, PxU32 ball_group);
+
+		// Kick model (see GameScene::UpdateTrajectory) and the aim and power spread of a player
+		void Kick(PxReal _arm_length, PxReal _launch_angle, PxReal _aim_spread = 0.05f, PxReal _power_spread = 2.0f);
+
+		// Add a kicker position and power to the map
+		void Cell(const PxVec3& position, int power);
+
+		// Build the worker scenes and start kicking (never blocks)
+		void Start(PxU32 kicks_per_cell);
+
+		// All kicks done?
+		bool Done();
+
+		// Fraction of kicks done
+		PxReal Progress();
+
+		// The probability map (valid once Done)
+		const vector<ShotCell>& Cells();
+
+		// Write the probability map as CSV
+		bool Write(const string& path);
+
+		// Stop the workers and release the worker scenes and shared shapes
+		void Release();
+
+	private:
+		// Shared shapes of one source actor
+		struct Source
+		{
+			PxTransform pose;
+			vector<PxShape*> shapes;
+			PxReal mass;
+			PxVec3 inertia;
+			PxTransform mass_pose;
+		};
+
+		// A headless pitch
+		struct Worker
+		{
+			PxScene* scene;
+			PxDefaultCpuDispatcher* dispatcher;
+			vector<PxRigidDynamic*> obstacles;
+			vector<PxRigidDynamic*> balls;
+			vector<PxU32> goals;
+			vector<PxU32> targets;
+			thread runner;
+		};
+
+		// Make shared copies of an actor's shapes
+		Source Share(PxRigidActor* actor);
+
+		// Build a worker's scene from the shared shapes
+		void Build(Worker& worker);
+
+		// Worker loop
+		void Run(PxU32 index);
+
+		// Kick one of the balls once and see where it ends up
+		ShotOutcome Shoot(Worker& worker, PxU32 ball, const ShotCell& cell, PxReal yaw, PxReal power);
+
+		// Keep a ball still and out of the way while the others are kicked
+		void Park(Worker& worker, PxU32 ball);
+
+		// Shared shapes
+		vector<Source> statics;
+		vector<Source> obstacles;
+		vector<Source> balls;
+
+		// Outcome regions, and the ball filter group each target falls for
+		vector<PxBounds3> goals;
+		vector<PxBounds3> targets;
+		vector<PxU32> target_groups;
+
+		// Kick model
+		PxReal arm_length;
+		PxReal launch_angle;
+		PxReal aim_spread;
+		PxReal power_spread;
+
+		// Cells and kicks
+		vector<ShotCell> cells;
+		PxU32 kicks_per_cell;
+		atomic<PxU32> next_kick;
+		atomic<PxU32> done_kicks;
+		atomic<bool> running;
+
+		// Workers
+		PxU32 worker_count;
+		vector<Worker*> workers;
+		PxSimulationFilterShader filter_shader;
+	};
+}
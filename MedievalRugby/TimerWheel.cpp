@@ -0,0 +1,183 @@
+#include "TimerWheel.h"
+
+// Physics engine namespace
+namespace PhysicsEngine
+{
+	// Constructor
+	TimerWheel::TimerWheel(PxReal _tick) : tick(_tick), current(0), remainder(0.0f), count(0)
+	{
+		for (PxU32 i = 0; i < level0_size; i++) level0[i] = none;
+		for (PxU32 i = 0; i < level1_size; i++) level1[i] = none;
+	}
+
+	// Ticks from seconds
+	PxU32 TimerWheel::Ticks(PxReal seconds)
+	{
+		if (seconds <= 0.0f)
+			return 1;
+
+		// Small tolerance so float error does not cost a whole tick
+		PxU32 ticks = (PxU32)PxCeil(seconds / tick - 1e-3f);
+		return ticks ? ticks : 1;
+	}
+
+	// Schedule an event
+	TimerId TimerWheel::Schedule(PxReal delay, function<void()> callback, PxReal repeat)
+	{
+		PxU32 index;
+		if (free_timers.size())
+		{
+			index = free_timers.back();
+			free_timers.pop_back();
+		}
+		else
+		{
+			index = (PxU32)timers.size();
+			timers.push_back(Timer());
+			timers[index].generation = 0;
+		}
+
+		Timer& timer = timers[index];
+		timer.callback = callback;
+		timer.expiry = current + Ticks(delay);
+		timer.repeat = repeat > 0.0f ? Ticks(repeat) : 0;
+		timer.slot = 0;
+		Insert(index);
+		count++;
+
+		TimerId id;
+		id.index = index;
+		id.generation = timer.generation;
+		return id;
+	}
+
+	// Is an event still waiting?
+	bool TimerWheel::Pending(const TimerId& id)
+	{
+		return id.index < timers.size() && timers[id.index].generation == id.generation && timers[id.index].slot;
+	}
+
+	// Cancel an event
+	bool TimerWheel::Cancel(TimerId& id)
+	{
+		if (!Pending(id))
+			return false;
+
+		Unlink(id.index);
+		Free(id.index);
+		id = TimerId();
+		return true;
+	}
+
+	// Put an event in its slot
+	void TimerWheel::Insert(PxU32 index)
+	{
+		Timer& timer = timers[index];
+
+		PxU32* slot;
+		if (timer.expiry - current < level0_size)
+			slot = &level0[timer.expiry & (level0_size - 1)];
+		else if ((timer.expiry >> level0_bits) - (current >> level0_bits) < level1_size)
+			slot = &level1[(timer.expiry >> level0_bits) & (level1_size - 1)];
+		else
+			// Further than the wheel reaches - parked in the last slot and re-inserted when it cascades
+			slot = &level1[((current >> level0_bits) + level1_size - 1) & (level1_size - 1)];
+
+		timer.slot = slot;
+		timer.prev = none;
+		timer.next = *slot;
+		if (*slot != none) timers[*slot].prev = index;
+		*slot = index;
+	}
+
+	// Take an event out of its slot
+	void TimerWheel::Unlink(PxU32 index)
+	{
+		Timer& timer = timers[index];
+
+		if (timer.prev != none) timers[timer.prev].next = timer.next;
+		else *timer.slot = timer.next;
+		if (timer.next != none) timers[timer.next].prev = timer.prev;
+
+		timer.slot = 0;
+	}
+
+	// Return an event to the free list
+	void TimerWheel::Free(PxU32 index)
+	{
+		Timer& timer = timers[index];
+		timer.callback = nullptr;
+		timer.generation++;
+		free_timers.push_back(index);
+		count--;
+	}
+
+	// Move time forward
+	void TimerWheel::Advance(PxReal dt)
+	{
+		remainder += dt;
+		while (remainder >= tick)
+		{
+			remainder -= tick;
+			Tick();
+		}
+	}
+
+	// Run one tick
+	void TimerWheel::Tick()
+	{
+		current++;
+
+		// Start of a new lap - spread the next level 1 slot over level 0
+		if (!(current & (level0_size - 1)))
+		{
+			PxU32* slot = &level1[(current >> level0_bits) & (level1_size - 1)];
+			while (*slot != none)
+			{
+				PxU32 index = *slot;
+				Unlink(index);
+				Insert(index);
+			}
+		}
+
+		// Run the events due (one at a time, so callbacks may schedule or cancel)
+		PxU32* slot = &level0[current & (level0_size - 1)];
+		while (*slot != none)
+		{
+			PxU32 index = *slot;
+			Unlink(index);
+
+			// Keep the callback alive while it runs - it may schedule into this storage
+			function<void()> callback = timers[index].callback;
+			if (timers[index].repeat)
+			{
+				timers[index].expiry = current + timers[index].repeat;
+				Insert(index);
+			}
+			else
+				Free(index);
+
+			callback();
+		}
+	}
+
+	// Drop every event
+	void TimerWheel::Clear()
+	{
+		for (PxU32 i = 0; i < timers.size(); i++)
+		{
+			if (timers[i].slot)
+			{
+				Unlink(i);
+				Free(i);
+			}
+		}
+		remainder = 0.0f;
+	}
+
+	// Number of waiting events
+	PxU32 TimerWheel::Count()
+	{
+		return count;
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "PhysicsEngine.h"
+#include <functional>
+
+// Physics engine namespace
+namespace PhysicsEngine
+{
+	// Using the physx and std namespaces
+	using namespace physx;
+	using namespace std;
+
+	// Handle to a scheduled event (safe to cancel after it has run)
+	struct TimerId
+	{
+		PxU32 index;
+		PxU32 generation;
+
+		TimerId() : index(0xffffffff), generation(0) {}
+	};
+
+	// Two level hierarchical timer wheel - the cost of Advance depends on the ticks passed and the events due, not on how many are pending
+	class TimerWheel
+	{
+	public:
+		// Constructor (tick length in seconds)
+		TimerWheel(PxReal _tick = 0.01f);
+
+		// Run a callback after a delay, and again every repeat seconds if repeat > 0
+		TimerId Schedule(PxReal delay, function<void()> callback, PxReal repeat = 0.0f);
+
+		// Cancel a scheduled event (false if it already ran or was cancelled)
+		bool Cancel(TimerId& id);
+
+		// Is an event still waiting?
+		bool Pending(const TimerId& id);
+
+		// Move time forward and run the events that fall due
+		void Advance(PxReal dt);
+
+		// Drop every event
+		void Clear();
+
+		// Number of waiting events
+		PxU32 Count();
+
+	private:
+		// Wheel sizes
+		static const PxU32 level0_bits = 8;
+		static const PxU32 level0_size = 1 << level0_bits;
+		static const PxU32 level1_size = 64;
+		static const PxU32 none = 0xffffffff;
+
+		// An event (intrusive doubly linked list per slot)
+		struct Timer
+		{
+			function<void()> callback;
+			PxU64 expiry;
+			PxU32 repeat;
+			PxU32 generation;
+			PxU32 prev;
+			PxU32 next;
+			PxU32* slot;
+		};
+
+		// Put an event in the slot its expiry belongs to
+		void Insert(PxU32 index);
+
+		// Take an event out of its slot
+		void Unlink(PxU32 index);
+
+		// Return an event to the free list
+		void Free(PxU32 index);
+
+		// Run one tick
+		void Tick();
+
+		// Ticks from seconds (at least one)
+		PxU32 Ticks(PxReal seconds);
+
+		// Event storage and free list
+		vector<Timer> timers;
+		vector<PxU32> free_timers;
+
+		// Slot list heads
+		PxU32 level0[level0_size];
+		PxU32 level1[level1_size];
+
+		// Tick length, current tick and time not yet ticked
+		PxReal tick;
+		PxU64 current;
+		PxReal remainder;
+
+		// Waiting events
+		PxU32 count;
+	};
+}
@@ -0,0 +1,145 @@
+#include "TrajectoryPreview.h"
+#include <chrono>
+
+// Physics engine namespace
+namespace PhysicsEngine
+{
+	// Shadow scene time step, and how many steps go between path points
+	static const PxReal preview_step = 1.0f / 60.0f;
+	static const PxU32 steps_per_point = 2;
+
+	// Constructor
+	TrajectoryPreview::TrajectoryPreview() : px_scene(0), dispatcher(0), statics(0), ball(0), running(false)
+	{
+	}
+
+	// Destructor
+	TrajectoryPreview::~TrajectoryPreview()
+	{
+		Release();
+	}
+
+	// Build the shadow scene and start the worker
+	void TrajectoryPreview::Init(PxRigidActor* source_statics, PxRigidActor* source_ground, PxRigidDynamic* source_ball, PxSimulationFilterShader filter_shader)
+	{
+		Release();
+
+		// Shadow scene - simulated on the worker thread itself
+		PxSceneDesc sceneDesc(GetPhysics()->getTolerancesScale());
+		dispatcher = PxDefaultCpuDispatcherCreate(0);
+		sceneDesc.cpuDispatcher = dispatcher;
+		sceneDesc.filterShader = filter_shader;
+		sceneDesc.gravity = PxVec3(0.0f, -9.81f, 0.0f);
+		sceneDesc.flags |= PxSceneFlag::eENABLE_CCD;
+		px_scene = GetPhysics()->createScene(sceneDesc);
+		if (!px_scene) throw new Exception("TrajectoryPreview::Init, Could not create the shadow scene.");
+
+		// Static geometry and the ground plane under it (when the level has one), copied once
+		statics = GetPhysics()->createRigidStatic(source_statics->getGlobalPose());
+		CopyShapes(source_statics, statics);
+		if (source_ground)
+			CopyShapes(source_ground, statics, statics->getGlobalPose().getInverse() * source_ground->getGlobalPose());
+		px_scene->addActor(*statics);
+
+		// Ball with the same shapes and mass (CCD like the pool balls)
+		ball = GetPhysics()->createRigidDynamic(source_ball->getGlobalPose());
+		CopyShapes(source_ball, ball);
+		ball->setMass(source_ball->getMass());
+		ball->setMassSpaceInertiaTensor(source_ball->getMassSpaceInertiaTensor());
+		ball->setCMassLocalPose(source_ball->getCMassLocalPose());
+		ball->setLinearDamping(source_ball->getLinearDamping());
+		ball->setAngularDamping(source_ball->getAngularDamping());
+		ball->setRigidBodyFlag(PxRigidBodyFlag::eENABLE_CCD, true);
+		px_scene->addActor(*ball);
+
+		// Start the worker
+		running = true;
+		worker = thread(&TrajectoryPreview::Run, this);
+	}
+
+	// Stop the worker and release the shadow scene
+	void TrajectoryPreview::Release()
+	{
+		running = false;
+		if (worker.joinable())
+			worker.join();
+
+		// Actors first - releasing a scene does not release the actors in it
+		if (ball) ball->release();
+		if (statics) statics->release();
+		if (px_scene) px_scene->release();
+		if (dispatcher) dispatcher->release();
+
+		px_scene = 0;
+		dispatcher = 0;
+		statics = 0;
+		ball = 0;
+	}
+
+	// Ask for a flight
+	void TrajectoryPreview::Request(const PxTransform& pose, const PxVec3& velocity)
+	{
+		Launch& launch = launches.Back();
+		launch.pose = pose;
+		launch.velocity = velocity;
+		launches.Publish();
+	}
+
+	// Newest finished path
+	const TrajectoryPath& TrajectoryPreview::Latest()
+	{
+		paths.Consume();
+		return paths.Front();
+	}
+
+	// Running?
+	bool TrajectoryPreview::Running()
+	{
+		return running;
+	}
+
+	// Worker loop
+	void TrajectoryPreview::Run()
+	{
+		while (running)
+		{
+			// Nothing new to predict
+			if (!launches.Consume())
+			{
+				this_thread::sleep_for(chrono::milliseconds(2));
+				continue;
+			}
+
+			Predict(launches.Front(), paths.Back());
+			paths.Publish();
+		}
+	}
+
+	// Step the shadow scene from a launch
+	void TrajectoryPreview::Predict(const Launch& launch, TrajectoryPath& path)
+	{
+		ball->setGlobalPose(launch.pose);
+		ball->setLinearVelocity(launch.velocity);
+		ball->setAngularVelocity(PxVec3(0.0f, 0.0f, 0.0f));
+		ball->wakeUp();
+
+		path.count = 0;
+		path.points[path.count++] = launch.pose.p;
+
+		for (PxU32 step = 1; path.count < TrajectoryPath::max_points; step++)
+		{
+			px_scene->simulate(preview_step);
+			px_scene->fetchResults(true);
+
+			// Landed and stopped, or fell off the world - always end on the last position
+			PxVec3 position = ball->getGlobalPose().p;
+			bool done = ball->isSleeping() || position.y < -5.0f;
+			if (done || (step % steps_per_point == 0))
+				path.points[path.count++] = position;
+
+			// Finished, or shutting down
+			if (done || !running)
+				break;
+		}
+	}
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include "PhysicsEngine.h"
+#include <atomic>
+#include <thread>
+
+// Physics engine namespace
+namespace PhysicsEngine
+{
+	// Using the physx and std namespaces
+	using namespace physx;
+	using namespace std;
+
+	// Latest value handoff between one writer and one reader thread - neither side ever waits
+	template<class T>
+	class TripleBuffer
+	{
+	public:
+		// Constructor
+		TripleBuffer() : back(0), middle(1), front(2) {}
+
+		// Writer: the buffer to fill
+		T& Back() { return buffers[back]; }
+
+		// Writer: hand the filled buffer over
+		void Publish() { back = middle.exchange(back | fresh) & index; }
+
+		// Reader: take the newest buffer if there is one
+		bool Consume()
+		{
+			if (!(middle.load() & fresh)) return false;
+			front = middle.exchange(front) & index;
+			return true;
+		}
+
+		// Reader: the newest buffer taken
+		const T& Front() const { return buffers[front]; }
+
+	private:
+		// Middle index bits
+		static const unsigned index = 3;
+		static const unsigned fresh = 4;
+
+		// Buffers
+		T buffers[3];
+
+		// Buffer owned by the writer
+		unsigned back;
+
+		// Buffer in between (plus the fresh bit)
+		atomic<unsigned> middle;
+
+		// Buffer owned by the reader
+		unsigned front;
+	};
+
+	// A predicted ball flight
+	struct TrajectoryPath
+	{
+		// Most points in a path
+		static const PxU32 max_points = 120;
+
+		// Points along the flight
+		PxVec3 points[max_points];
+
+		// Number of points
+		PxU32 count;
+
+		TrajectoryPath() : count(0) {}
+	};
+
+	// Predicts the ball flight by stepping a shadow scene (ball and static geometry only) on a worker thread
+	class TrajectoryPreview
+	{
+	public:
+		// Constructor
+		TrajectoryPreview();
+
+		// Destructor
+		~TrajectoryPreview();
+
+		// Build the shadow scene from copies of the static geometry, the ground (may be null) and the ball, and start the worker
+		void Init(PxRigidActor* statics, PxRigidActor* ground, PxRigidDynamic* ball, PxSimulationFilterShader filter_shader);
+
+		// Stop the worker and release the shadow scene
+		void Release();
+
+		// Ask for the flight from a launch pose and velocity (never blocks)
+		void Request(const PxTransform& pose, const PxVec3& velocity);
+
+		// Newest finished path (never blocks)
+		const TrajectoryPath& Latest();
+
+		// Running?
+		bool Running();
+
+	private:
+		// A launch to predict
+		struct Launch
+		{
+			PxTransform pose;
+			PxVec3 velocity;
+		};
+
+		// Worker loop
+		void Run();
+
+		// Step the shadow scene from a launch
+		void Predict(const Launch& launch, TrajectoryPath& path);
+
+		// Shadow scene
+		PxScene* px_scene;
+		PxDefaultCpuDispatcher* dispatcher;
+		PxRigidStatic* statics;
+		PxRigidDynamic* ball;
+
+		// Handoffs
+		TripleBuffer<Launch> launches;
+		TripleBuffer<TrajectoryPath> paths;
+
+		// Worker
+		thread worker;
+		atomic<bool> running;
+	};
+}
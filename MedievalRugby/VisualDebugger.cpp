@@ -5,6 +5,7 @@
 #include "Extras\Camera.h"
 #include "Extras\Renderer.h"
 #include "Extras\HUD.h"
+#include "Extras\Input.h"
 
 // Visual debugger namespace
 namespace VisualDebugger
@@ -39,11 +40,11 @@ namespace VisualDebugger
 	// Render mode
 	RenderMode render_mode = NORMAL;
 
-	// Keys
-	const int MAX_KEYS = 256;
+	// Key events and held actions
+	Input input;
 
-	// Key presses
-	bool key_state[MAX_KEYS];
+	// Step physics with the new input before rendering (instead of after)
+	bool low_latency = false;
 
 	// SHow hud
 	bool hud_show = true;
@@ -51,6 +52,12 @@ namespace VisualDebugger
 	// Hud
 	HUD hud;
 
+	// Values the game lines of the hud show
+	static int hud_score		= -1;
+	static float hud_power		= -1.0f;
+	static int hud_balls		= -2;
+	static int hud_castles		= -1;
+
 	// Frame count
 	static int updateCount	= 0;
 	static int frame		= 0;
@@ -76,6 +83,14 @@ namespace VisualDebugger
 		// Make a camera
 		camera = new Camera(PxVec3(0.0f, 25.0f, 60.0f), PxVec3(0.0f, -0.35f, -1.0f), 50.0f);
 
+		// Free camera keys
+		input.Map('W', ACTION_CAMERA_FORWARD);
+		input.Map('S', ACTION_CAMERA_BACKWARD);
+		input.Map('A', ACTION_CAMERA_LEFT);
+		input.Map('D', ACTION_CAMERA_RIGHT);
+		input.Map('E', ACTION_CAMERA_UP);
+		input.Map('Q', ACTION_CAMERA_DOWN);
+
 		// Initialise HUD
 		HUDInit();
 		hud_show = true;
@@ -113,7 +128,7 @@ namespace VisualDebugger
 		hud.AddLine(GAME, "Render Time: ");
 		hud.AddLine(GAME, "Simulation Time: ");
 		hud.AddLine(GAME, "FPS: ");
-		hud.AddLine(GAME, "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\nPress 'F4' to switch to help HUD");
+		hud.AddLine(GAME, "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\nPress 'F4' to switch to help HUD");
 
 		// Add a help screen
 		hud.AddLine(HELP, "Press 'C' to increase power of shot");
@@ -126,6 +141,9 @@ namespace VisualDebugger
 		hud.AddLine(HELP, "Press 'N' to spawn balls");
 		hud.AddLine(HELP, "Press 'M' to create a new game scene");
 		hud.AddLine(HELP, "Press 'J' to delete a newly created game scene");
+		hud.AddLine(HELP, "Press 'K' to build the shot probability map (shot_map.csv)");
+		hud.AddLine(HELP, "Press 'L' to write the built-in level (level_default.mrl)");
+		hud.AddLine(HELP, "Press 'X' to fill the scene to 1000 entities (update benchmark)");
 		hud.AddLine(HELP, "W / A /S / D / E / Q / Mouse for free camera controls ");
 		hud.AddLine(HELP, "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\nHow to play:\n - Destroy the castles by hitting the coloured targets above them.\n - Only blue balls can hit blue targets and red balls red targets.\n - Destroying a castle opens the draw bridge a small amount.\n - Hit the ball between the goal posts to score a goal.\n - Use the keys listed above to control the kicking machine.");
 		hud.AddLine(HELP, "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\nPress 'F4' to switch to game HUD");
@@ -154,12 +172,15 @@ namespace VisualDebugger
 			camera->setEye(((PxRigidBody*)scene->kickerBase->Get())->getGlobalPose().p + PxVec3(0.0f, 15.0f, 25.0f));
 		}
 
-		// Reset timer
-		renderTimer.ResetHighResTimer();
-
 		// Handle pressed keys
 		KeyHold();
 
+		// Low latency - the new input reaches the step before the frame is drawn
+		if (low_latency) Simulate();
+
+		// Reset timer
+		renderTimer.ResetHighResTimer();
+
 		// Start rendering
 		Renderer::Start(camera->getEye(), camera->getDir());
 
@@ -172,26 +193,42 @@ namespace VisualDebugger
 		// Set the render mode - normal
 		if ((render_mode == NORMAL) || (render_mode == BOTH))
 		{
-			std::vector<PxActor*> actors = scene->GetAllActors();
-			if (actors.size()) Renderer::Render(&actors[0], (PxU32)actors.size());
+			const std::vector<PxActor*>& actors = scene->RenderList();
+			if (actors.size()) Renderer::Render(&actors[0], (PxU32)actors.size(), scene->Generation());
 		}
 
-		// Set the hud score
+		// Predicted flight of the loaded ball
+		const PhysicsEngine::TrajectoryPath* path = scene->Trajectory();
+		if (path) Renderer::RenderPath(path->points, path->count, PxVec3(1.0f, 1.0f, 0.0f));
+
+		// Set the hud score (the game lines are only rebuilt when their value changes)
 		int score = scene->Score();
-		hud.SetScore(GAME, "Score: " + to_string(score));
+		if (score != hud_score) hud.SetScore(GAME, "Score: " + to_string(score));
+		hud_score = score;
 
 		// Set the hud power 
-		float power = scene->Power();
-		hud.SetPower(GAME, "Shot Power: " + hud.RemoveZero(to_string(roundf(power * 1000) / 1000)));
+		float power = roundf(scene->Power() * 1000) / 1000;
+		if (power != hud_power) hud.SetPower(GAME, "Shot Power: " + hud.RemoveZero(to_string(power)));
+		hud_power = power;
 
 		// Set the hud balls 
 		int balls = scene->Balls();
-		if (balls == 0) hud.SetBalls(GAME, "Last Ball");
-		else hud.SetBalls(GAME, "Balls Remaining: " + to_string(balls + 1));
+		if (balls != hud_balls)
+		{
+			if (balls == 0) hud.SetBalls(GAME, "Last Ball");
+			else hud.SetBalls(GAME, "Balls Remaining: " + to_string(balls + 1));
+		}
+		hud_balls = balls;
 
 		// Set the hud balls 
 		int castles = scene->DestroyedCastles();
-		hud.SetCastles(GAME, "Castles Destroyed: " + to_string(castles) + "/4");
+		if (castles != hud_castles)
+		{
+			hud.SetCastles(GAME, "Castles Destroyed: " + to_string(castles) + "/4 (red "
+				+ to_string(scene->DestroyedCastles(PhysicsEngine::TEAM_RED)) + " / blue "
+				+ to_string(scene->DestroyedCastles(PhysicsEngine::TEAM_BLUE)) + ")");
+		}
+		hud_castles = castles;
 
 		// FPS
 		frame++;
@@ -230,8 +267,32 @@ namespace VisualDebugger
 				+ hud.RemoveZero(to_string(fps))
 				+ "\nObject count in this scene: " 
 				+ to_string(scene->Objects())
+				+ " (culled shapes: " + to_string(Renderer::CulledShapes()) + " / " + to_string(Renderer::TotalShapes()) + ")"
+				+ "\nOut of bounds: "
+				+ to_string(scene->OutOfBoundsAsleep()) + " asleep / "
+				+ to_string(scene->OutOfBoundsRemoved()) + " removed"
+				+ "\nBroadphase pairs added / removed: "
+				+ to_string(scene->BroadPhaseAdds()) + " / "
+				+ to_string(scene->BroadPhaseRemoves())
+				+ (scene->useAggregates ? " (aggregates on)" : " (aggregates off)")
+				+ "\nShot map: "
+				+ scene->ShotStatus()
+				+ "\nFlags (full / reduced / frozen): "
+				+ to_string(scene->flagLOD.Count(PhysicsEngine::CLOTH_FULL)) + " / "
+				+ to_string(scene->flagLOD.Count(PhysicsEngine::CLOTH_REDUCED)) + " / "
+				+ to_string(scene->flagLOD.Count(PhysicsEngine::CLOTH_FROZEN))
 				+ "\nGame scene count: "
-				+ to_string(extraScenes.size() + 1)
+				+ to_string(extraScenes.size() + 1) + " (level: " + scene->LevelStatus() + ")"
+				+ "\nScene init (ms): "
+				+ hud.RemoveZero(to_string(scene->InitTime()))
+				+ (scene->bulkInsert ? " (bulk insert on)" : " (bulk insert off)")
+				+ "\nCustom update (us): "
+				+ hud.RemoveZero(to_string(roundf(scene->CustomUpdateTime() * 10.0f) / 10.0f))
+				+ " (" + to_string(scene->entities.Size()) + " entities)"
+				+ "\nInput latency (ms): "
+				+ hud.RemoveZero(to_string(roundf(input.Latency() * 10.0f) / 10.0f)) + " avg / "
+				+ hud.RemoveZero(to_string(roundf(input.LatencyMax() * 10.0f) / 10.0f)) + " max"
+				+ (low_latency ? " (low latency on)" : " (low latency off)")
 			);
 		}
 
@@ -253,12 +314,26 @@ namespace VisualDebugger
 		lastRenderTime = renderTime;
 		renderTime = renderTimer.GetHighResTimer();
 
+		// Default - the input waits for the frame to be drawn
+		if (!low_latency) Simulate();
+	}
+
+	// Perform a single simulation step
+	void Simulate()
+	{
+		// Flag detail follows what the camera can see
+		scene->flagLOD.View(camera->getEye(), camera->getDir(), 60.0f, (PxReal)glutGet(GLUT_WINDOW_WIDTH), (PxReal)glutGet(GLUT_WINDOW_HEIGHT));
+
 		// Reset the timer
 		simulationTimer.ResetHighResTimer();
 
 		// Perform a single simulation step
 		scene->Update(delta_time);
 
+		// The input handled so far is in this step - a paused scene doesn't step, so its input never lands and isn't timed
+		if (!scene->Pause()) input.Stepped();
+		else input.Discard();
+
 		// If the extra scene exsists update it!
 		for (int i = 0; i < extraScenes.size(); i++)
 		{
@@ -280,8 +355,13 @@ namespace VisualDebugger
 		case 'V': scene->KeyPressHandler(toupper(key)); break;
 		case 'B': scene->KeyPressHandler(toupper(key)); break;
 		case 'N': scene->KeyPressHandler(toupper(key)); break;
+		case 'K': scene->KeyPressHandler(toupper(key)); break;
+		case 'L': scene->KeyPressHandler(toupper(key)); break;
+		case 'X': scene->KeyPressHandler(toupper(key)); break;
 		case 'M': 
 			extraScenes.push_back(new PhysicsEngine::GameScene());
+			extraScenes.back()->showTrajectory = false;
+			extraScenes.back()->bulkInsert = scene->bulkInsert;
 			extraScenes.back()->Init();
 			break;
 		case 'J':
@@ -314,7 +394,7 @@ namespace VisualDebugger
 		}
 	}
 
-	// User defined key held down handler
+	// User defined key held down handler (called once when the key goes down, the release handler ends the hold)
 	void UserKeyHold(int key)
 	{
 		switch (toupper(key))
@@ -328,25 +408,26 @@ namespace VisualDebugger
 		}
 	}
 
-	// Handle camera control keys
-	void CameraInput(int key)
+	// Move the camera for as long as its keys were held since the last frame
+	void CameraInput(PxU32 actions)
 	{
-		// Switch on key
-		switch (toupper(key))
+		for (PxU32 i = 0; i < ACTION_COUNT; i++)
 		{
-		case 'W': camera->MoveForward(delta_time);	break;
-		case 'S': camera->MoveBackward(delta_time); break;
-		case 'A': camera->MoveLeft(delta_time);		break;
-		case 'D': camera->MoveRight(delta_time);	break;
-		case 'E': camera->MoveUp(delta_time);		break;
-		case 'Q': camera->MoveDown(delta_time);		break;
-		default: break;
-		}
-	}
+			if (!(actions & (1u << i)))
+				continue;
 
-	// Handle force control keys
-	void ForceInput(int key)
-	{
+			PxReal held = input.Held((InputAction)i);
+			switch (i)
+			{
+			case ACTION_CAMERA_FORWARD:		camera->MoveForward(held);	break;
+			case ACTION_CAMERA_BACKWARD:	camera->MoveBackward(held); break;
+			case ACTION_CAMERA_LEFT:		camera->MoveLeft(held);		break;
+			case ACTION_CAMERA_RIGHT:		camera->MoveRight(held);	break;
+			case ACTION_CAMERA_UP:			camera->MoveUp(held);		break;
+			case ACTION_CAMERA_DOWN:		camera->MoveDown(held);		break;
+			default: break;
+			}
+		}
 	}
 
 	// Handle special keys
@@ -377,6 +458,15 @@ namespace VisualDebugger
 
 		// Toggle scene pause
 		case GLUT_KEY_F10: scene->Pause(!scene->Pause()); break;
+
+		// Toggle low latency mode (step before rendering, compare input latency)
+		case GLUT_KEY_F2: low_latency = !low_latency; break;
+
+		// Toggle bulk actor insertion and rebuild the scene (compare init time)
+		case GLUT_KEY_F3: scene->bulkInsert = !scene->bulkInsert; scene->Reset(); break;
+
+		// Toggle broadphase aggregates and rebuild the scene (compare pairs / simulation time)
+		case GLUT_KEY_F11: scene->useAggregates = !scene->useAggregates; scene->Reset(); break;
 			
 		// Resect scene
 		case GLUT_KEY_F12: scene->Reset(); break;
@@ -387,45 +477,39 @@ namespace VisualDebugger
 	// Handle single key presses
 	void KeyPress(unsigned char key, int x, int y)
 	{
-		// Do it only once
-		if (key_state[key] == true) return;
-
-		// Set the key state
-		key_state[key] = true;
-
 		// Exit
 		if (key == 27) exit(0);
 
-		// User pressed a key
-		UserKeyPress(key);
+		// Handled with the rest of the frame's input
+		input.Push(key, true);
 	}
 
 	// Handle key release
 	void KeyRelease(unsigned char key, int x, int y)
 	{
-		key_state[key] = false;
-		UserKeyRelease(key);
+		input.Push(key, false);
 	}
 
-	// Handle holded keys
-	void KeyHold()
+	// Dispatch a queued key event
+	void KeyEvent(const InputEvent& event)
 	{
-		// Loop through the keys
-		for (int i = 0; i < MAX_KEYS; i++)
+		if (event.down)
 		{
-			// If key down
-			if (key_state[i]) 
-			{
-				// Camera controls - send keys
-				CameraInput(i);
+			UserKeyPress(event.key);
+			UserKeyHold(event.key);
+		}
+		else UserKeyRelease(event.key);
+	}
 
-				// Force control - send keys
-				ForceInput(i);
+	// Handle the input since the last frame
+	void KeyHold()
+	{
+		// Presses and releases in the order they happened
+		input.Poll(KeyEvent);
 
-				// User controls - send keys
-				UserKeyHold(i);
-			}
-		}
+		// Only the actions that were held
+		if (input.Touched())
+			CameraInput(input.Touched());
 	}
 
 	// Mouse handling
@@ -1,5 +1,6 @@
 #pragma once
 #include "Game.h"
+#include "Extras\Input.h"
 #include <iostream> 
 
 // The visual debugger namespace
@@ -30,6 +31,7 @@ namespace VisualDebugger
 	void KeySpecial(int key, int x, int y);
 	void KeyRelease(unsigned char key, int x, int y);
 	void KeyPress(unsigned char key, int x, int y);
+	void KeyEvent(const InputEvent& event);
 
 	// Function declarations - mouse movement
 	void motionCallback(int x, int y);
@@ -38,6 +40,7 @@ namespace VisualDebugger
 
 	// Scene functions
 	void RenderScene();
+	void Simulate();
 	void ToggleRenderMode();
 	void HUDInit();
 